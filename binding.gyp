@@ -7,6 +7,7 @@
         'src/odbc_connection.cpp',
         'src/odbc_statement.cpp',
         'src/odbc_result.cpp',
+        'src/odbc_worker_pool.cpp',
         'src/dynodbc.cpp'
       ],
 	  'include_dirs': [
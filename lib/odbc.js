@@ -17,6 +17,7 @@
 
 var odbc = require("bindings")("odbc_bindings")
   , SimpleQueue = require("./simple-queue")
+  , ResultStream = require("./result-stream")
   , util = require("util")
   ;
 
@@ -32,6 +33,13 @@ module.exports.ODBCConnection = odbc.ODBCConnection;
 module.exports.ODBCStatement = odbc.ODBCStatement;
 module.exports.ODBCResult = odbc.ODBCResult;
 module.exports.loadODBCLibrary = odbc.loadODBCLibrary;
+module.exports.setWorkerThreads = odbc.setWorkerThreads;
+module.exports.getWorkerThreads = odbc.getWorkerThreads;
+module.exports.ResultStream = ResultStream;
+
+module.exports.FETCH_ARRAY = odbc.ODBC.FETCH_ARRAY;
+module.exports.FETCH_OBJECT = odbc.ODBC.FETCH_OBJECT;
+module.exports.FETCH_COLUMNS = odbc.ODBC.FETCH_COLUMNS;
 
 module.exports.open = function (connectionString, options, cb) {
   var db;
@@ -68,6 +76,7 @@ function Database(options) {
   self.odbc = (options.odbc) ? options.odbc : new odbc.ODBC();
   self.queue = new SimpleQueue();
   self.fetchMode = options.fetchMode || null;
+  self.fetchSize = options.fetchSize || null;
   self.connected = false;
   self.connectTimeout = (options.hasOwnProperty('connectTimeout')) 
     ? options.connectTimeout
@@ -77,6 +86,14 @@ function Database(options) {
     ? options.loginTimeout
     : null
     ;
+  self.statementCacheSize = (options.hasOwnProperty('statementCacheSize'))
+    ? options.statementCacheSize
+    : null
+    ;
+  self.asyncPolling = options.asyncPolling || false;
+  self.queryTimeout = options.queryTimeout || 0;
+  self.lockMode = options.lockMode || null;
+  self.pinnedWorker = options.pinnedWorker || false;
 }
 
 //Expose constants
@@ -114,6 +131,19 @@ Database.prototype.open = function (connectionString, cb) {
     if (self.loginTimeout || self.loginTimeout === 0) {
       self.conn.loginTimeout = self.loginTimeout;
     }
+    
+    if (self.statementCacheSize || self.statementCacheSize === 0) {
+      self.conn.statementCacheSize = self.statementCacheSize;
+    }
+    
+    self.conn.asyncPolling = self.asyncPolling;
+    self.conn.queryTimeout = self.queryTimeout;
+    
+    if (self.lockMode) {
+      self.conn.lockMode = self.lockMode;
+    }
+    
+    self.conn.pinnedWorker = self.pinnedWorker;
 
     self.conn.open(connectionString, function (err, result) {
       if (err) return cb(err);
@@ -138,6 +168,19 @@ Database.prototype.openSync = function (connectionString) {
     self.conn.loginTimeout = self.loginTimeout;
   }
   
+  if (self.statementCacheSize || self.statementCacheSize === 0) {
+    self.conn.statementCacheSize = self.statementCacheSize;
+  }
+  
+  self.conn.asyncPolling = self.asyncPolling;
+  self.conn.queryTimeout = self.queryTimeout;
+  
+  if (self.lockMode) {
+    self.conn.lockMode = self.lockMode;
+  }
+  
+  self.conn.pinnedWorker = self.pinnedWorker;
+  
   if (typeof(connectionString) == "object") {
     var obj = connectionString;
     connectionString = "";
@@ -200,63 +243,41 @@ Database.prototype.query = function (sql, params, cb) {
   }
   
   self.queue.push(function (next) {
-    function cbQuery (initialErr, result) {
-      fetchMore();
-      
-      function fetchMore() {
-        if (self.fetchMode) {
-          result.fetchMode = self.fetchMode;
-        }
-         
-        result.fetchAll(function (err, data) {
-          var moreResults, moreResultsError = null;
-          
-          try {
-            moreResults = result.moreResultsSync();
-          }
-          catch (e) {
-            moreResultsError = e;
-            //force to check for more results
-            moreResults = true;
-          }
-          
-          //close the result before calling back
-          //if there are not more result sets
-          if (!moreResults) {
-            result.closeSync();
-          }
-          
-          cb(err || initialErr, data, moreResults);
-          initialErr = null;
-            
-          while (moreResultsError) {
-            try {
-              moreResults = result.moreResultsSync();
-              cb(moreResultsError, [], moreResults); // No errors left - still need to report the
-                                                     // last one, though
-              moreResultsError = null;
-            } catch (e) {
-              cb(moreResultsError, [], moreResults);
-              moreResultsError = e;
-            } 
-          }
-          
-          if (moreResults) {
-            return fetchMore();
-          }
-          else {
-            return next();
-          }
-        });
-      }
-    }
+    //sql may also be an object of query options: { sql, params, timeout }
+    var options = (typeof(sql) == 'object')
+      ? { sql : sql.sql, params : sql.params, timeout : sql.timeout }
+      : { sql : sql };
     
     if (params) {
-      self.conn.query(sql, params, cbQuery);
+      options.params = params;
     }
-    else {
-      self.conn.query(sql, cbQuery);
+    
+    if (self.fetchMode) {
+      options.fetchMode = self.fetchMode;
     }
+    
+    if (self.fetchSize) {
+      options.fetchSize = self.fetchSize;
+    }
+    
+    //queryAll executes the query, fetches every result set and frees the
+    //statement in one trip to the thread pool
+    self.conn.queryAll(options, function (err, sets) {
+      if (!sets.length) {
+        cb(err, [], false);
+        
+        return next();
+      }
+      
+      //call back once per result set; an error belongs to the last one
+      for (var i = 0; i < sets.length; i++) {
+        var last = (i === sets.length - 1);
+        
+        cb(last ? err : null, sets[i], !last);
+      }
+      
+      return next();
+    });
   });
 };
 
@@ -292,6 +313,10 @@ Database.prototype.queryResult = function (sql, params, cb) {
         result.fetchMode = self.fetchMode;
       }
       
+      if (self.fetchSize) {
+        result.fetchSize = self.fetchSize;
+      }
+      
       cb(err, result);
       
       return next();
@@ -299,6 +324,127 @@ Database.prototype.queryResult = function (sql, params, cb) {
   });
 };
 
+Database.prototype.queryEach = function (sql, params, eachCb, cb) {
+  var self = this;
+  
+  if (typeof(params) == 'function') {
+    cb = eachCb;
+    eachCb = params;
+    params = null;
+  }
+  
+  if (!self.connected) {
+    return cb({ message : "Connection not open."}, 0);
+  }
+  
+  self.queue.push(function (next) {
+    function cbQuery (err, result) {
+      if (err) {
+        cb(err, 0);
+        
+        return next();
+      }
+      
+      if (self.fetchMode) {
+        result.fetchMode = self.fetchMode;
+      }
+      
+      if (self.fetchSize) {
+        result.fetchSize = self.fetchSize;
+      }
+      
+      result.fetchEach(eachCb, function (err, count) {
+        result.closeSync();
+        
+        cb(err, count);
+        
+        return next();
+      });
+    }
+    
+    if (params) {
+      self.conn.query(sql, params, cbQuery);
+    }
+    else {
+      self.conn.query(sql, cbQuery);
+    }
+  });
+};
+
+Database.prototype.queryStream = function (sql, params) {
+  var self = this
+    , stream = new ResultStream()
+    ;
+  
+  if (!self.connected) {
+    process.nextTick(function () {
+      stream.emit("error", { message : "Connection not open."});
+    });
+    
+    return stream;
+  }
+  
+  self.queue.push(function (next) {
+    function cbQuery (err, result) {
+      if (err) {
+        stream.emit("error", err);
+        
+        return next();
+      }
+      
+      if (self.fetchMode) {
+        result.fetchMode = self.fetchMode;
+      }
+      
+      if (self.fetchSize) {
+        result.fetchSize = self.fetchSize;
+      }
+      
+      //the connection is busy until the stream is done with the result,
+      //however it finishes
+      var finished = false;
+      
+      function done() {
+        if (finished) {
+          return;
+        }
+        
+        finished = true;
+        
+        stream.removeListener("end", done);
+        stream.removeListener("error", done);
+        stream.removeListener("close", done);
+        stream.onDestroy = null;
+        
+        result.closeSync();
+        
+        return next();
+      }
+      
+      stream.on("end", done);
+      stream.on("error", done);
+      stream.on("close", done);
+      stream.onDestroy = done;
+      
+      //destroyed before the query had even run
+      if (stream.destroyed) {
+        return done();
+      }
+      
+      stream.setResult(result);
+    }
+    
+    if (params) {
+      self.conn.query(sql, params, cbQuery);
+    }
+    else {
+      self.conn.query(sql, cbQuery);
+    }
+  });
+  
+  return stream;
+};
+
 Database.prototype.queryResultSync = function (sql, params) {
   var self = this, result;
   
@@ -317,6 +463,10 @@ Database.prototype.queryResultSync = function (sql, params) {
     result.fetchMode = self.fetchMode;
   }
   
+  if (self.fetchSize) {
+    result.fetchSize = self.fetchSize;
+  }
+  
   return result;
 };
 
@@ -338,6 +488,10 @@ Database.prototype.querySync = function (sql, params) {
     result.fetchMode = self.fetchMode;
   }
   
+  if (self.fetchSize) {
+    result.fetchSize = self.fetchSize;
+  }
+  
   var data = result.fetchAllSync();
   
   result.closeSync();
@@ -531,6 +685,7 @@ Database.prototype.prepareSync = function (sql, cb) {
 odbc.ODBCStatement.prototype._execute = odbc.ODBCStatement.prototype.execute;
 odbc.ODBCStatement.prototype._executeDirect = odbc.ODBCStatement.prototype.executeDirect;
 odbc.ODBCStatement.prototype._executeNonQuery = odbc.ODBCStatement.prototype.executeNonQuery;
+odbc.ODBCStatement.prototype._executeBatch = odbc.ODBCStatement.prototype.executeBatch;
 odbc.ODBCStatement.prototype._prepare = odbc.ODBCStatement.prototype.prepare;
 odbc.ODBCStatement.prototype._bind = odbc.ODBCStatement.prototype.bind;
 
@@ -545,20 +700,19 @@ odbc.ODBCStatement.prototype.execute = function (params, cb) {
   }
   
   self.queue.push(function (next) {
-    //If params were passed to this function, then bind them and
-    //then execute.
+    //If params were passed to this function, then they are written into
+    //the buffers that are already bound when they fit, and bound again 
+    //only when they do not, before the statement is executed.
     if (params) {
-      self._bind(params, function (err) {
-        if (err) {
-          return cb(err);
-        }
+      params = params.slice();
+      
+      var streams = getParameterStreams(params);
+      
+      self._execute(params, handleParameterStreams(self, streams, function (err, result) {
+        cb(err, result);
         
-        self._execute(function (err, result) {
-          cb(err, result);
-          
-          return next();
-        });
-      });
+        return next();
+      }));
     }
     //Otherwise execute and pop the next bind call
     else {
@@ -577,6 +731,120 @@ odbc.ODBCStatement.prototype.execute = function (params, cb) {
   });
 };
 
+//Readable streams and arrays of Buffers, given as parameter values or as
+//the value of a parameter descriptor, are sent to the driver a chunk at a
+//time with putData once the statement has been executed. Swap each of them
+//for a descriptor that asks for that, and return them by parameter index.
+function getParameterStreams(params) {
+  var streams = null;
+  
+  params.forEach(function (value, index) {
+    var descriptor = (value && !Buffer.isBuffer(value) && value.hasOwnProperty('type'))
+      ? value
+      : null
+      ;
+    var source = (descriptor) ? descriptor.value : value;
+    
+    if (!Array.isArray(source) && !(source && typeof source.pipe === 'function')) {
+      return;
+    }
+    
+    streams = streams || {};
+    streams[index] = source;
+    
+    params[index] = {
+      type : (descriptor) ? descriptor.type : odbc.ODBC.SQL_LONGVARBINARY
+      , size : (descriptor) ? descriptor.size : null
+      , length : (descriptor) ? descriptor.length : null
+      , stream : true
+    };
+  });
+  
+  return streams;
+}
+
+//Wrap an execute callback so that every parameter the driver asks for is
+//streamed to it before cb is called with the result.
+function handleParameterStreams(stmt, streams, cb) {
+  return function onExecute(err, result, param) {
+    if (err || typeof param !== 'number') {
+      return cb(err, result);
+    }
+    
+    var source = streams && streams[param];
+    
+    if (!source) {
+      try {
+        stmt.cancel();
+      }
+      catch (e) {}
+      
+      return cb(new Error("[node-odbc] No stream given for parameter " + param));
+    }
+    
+    putParameterStream(stmt, source, function (err) {
+      if (err) {
+        try {
+          stmt.cancel();
+        }
+        catch (e) {}
+        
+        return cb(err);
+      }
+      
+      //all of this parameter has been sent
+      stmt.putData(null, onExecute);
+    });
+  };
+}
+
+function putParameterStream(stmt, source, cb) {
+  if (Array.isArray(source)) {
+    var index = 0;
+    
+    return (function next(err) {
+      if (err || index >= source.length) {
+        return cb(err);
+      }
+      
+      stmt.putData(source[index++], next);
+    })();
+  }
+  
+  var done = false;
+  
+  function finish(err) {
+    if (done) {
+      return;
+    }
+    
+    done = true;
+    
+    source.removeListener('data', onData);
+    source.removeListener('end', finish);
+    source.removeListener('error', finish);
+    
+    cb(err);
+  }
+  
+  //only one chunk is held at a time; the stream waits until it is sent
+  function onData(chunk) {
+    source.pause();
+    
+    stmt.putData(Buffer.isBuffer(chunk) ? chunk : new Buffer(chunk), function (err) {
+      if (err) {
+        return finish(err);
+      }
+      
+      source.resume();
+    });
+  }
+  
+  source.on('data', onData);
+  source.on('end', finish);
+  source.on('error', finish);
+}
+
 odbc.ODBCStatement.prototype.executeDirect = function (sql, cb) {
   var self = this;
   
@@ -602,20 +870,19 @@ odbc.ODBCStatement.prototype.executeNonQuery = function (params, cb) {
   }
   
   self.queue.push(function (next) {
-    //If params were passed to this function, then bind them and
-    //then executeNonQuery.
+    //If params were passed to this function, then they are written into
+    //the buffers that are already bound when they fit, and bound again 
+    //only when they do not, before the statement is executed.
     if (params) {
-      self._bind(params, function (err) {
-        if (err) {
-          return cb(err);
-        }
+      params = params.slice();
+      
+      var streams = getParameterStreams(params);
+      
+      self._executeNonQuery(params, handleParameterStreams(self, streams, function (err, result) {
+        cb(err, result);
         
-        self._executeNonQuery(function (err, result) {
-          cb(err, result);
-          
-          return next();
-        });
-      });
+        return next();
+      }));
     }
     //Otherwise executeNonQuery and pop the next bind call
     else {
@@ -634,6 +901,27 @@ odbc.ODBCStatement.prototype.executeNonQuery = function (params, cb) {
   });
 };
 
+odbc.ODBCStatement.prototype.executeBatch = function (rows, cb) {
+  var self = this;
+  
+  self.queue = self.queue || new SimpleQueue();
+  
+  self.queue.push(function (next) {
+    try {
+      self._executeBatch(rows, function (err, count, status) {
+        cb(err, count, status);
+        
+        return next();
+      });
+    }
+    catch (e) {
+      cb(e, 0, []);
+      
+      return next();
+    }
+  });
+};
+
 odbc.ODBCStatement.prototype.prepare = function (sql, cb) {
   var self = this;
   
@@ -682,6 +970,10 @@ odbc.ODBCResult.prototype.fetch = function (cb) {
   });
 };
 
+odbc.ODBCResult.prototype.stream = function (options) {
+  return new ResultStream(this, options);
+};
+
 module.exports.Pool = Pool;
 
 Pool.count = 0;
@@ -689,130 +981,518 @@ Pool.count = 0;
 function Pool (options) {
   var self = this;
   self.index = Pool.count++;
-  self.availablePool = {};
-  self.usedPool = {};
+  self.groups = {};
   self.odbc = new odbc.ODBC();
   self.options = options || {}
   self.options.odbc = self.odbc;
+  
+  self.max = self.options.max || 0;
+  self.min = self.options.min || 0;
+  self.acquireTimeout = self.options.acquireTimeout || 0;
+  self.idleTimeout = self.options.idleTimeout || 0;
+  self.validateOnBorrow = (self.options.hasOwnProperty('validateOnBorrow'))
+    ? self.options.validateOnBorrow
+    : true
+    ;
+  self.validationQuery = self.options.validationQuery || null;
+  self.minIdle = self.options.minIdle || 0;
+  self.retryDelay = self.options.retryDelay || 1000;
+  
+  self.closed = false;
+  self.closing = 0;
+  self.closeCallback = null;
+  self.evictTimer = null;
+  
+  if (self.idleTimeout) {
+    self.evictTimer = setInterval(function () {
+      self._evict();
+    }, Math.max(Math.floor(self.idleTimeout / 2), 100));
+    
+    //an idle pool should not keep the process running
+    if (self.evictTimer.unref) {
+      self.evictTimer.unref();
+    }
+  }
+  
+  if (self.options.connectionString && self.options.initialSize) {
+    self.warm(self.options.connectionString, self.options.initialSize);
+  }
 }
 
+//the connections to one connection string
+Pool.prototype._group = function (connectionString) {
+  var self = this;
+  
+  if (!self.groups[connectionString]) {
+    self.groups[connectionString] = {
+      connectionString : connectionString
+      //open and not in use, the most recently returned last
+      , available : []
+      //handed out by open()
+      , used : []
+      //closed by whoever had them and being reset
+      , returning : []
+      //callers of open() waiting for a connection, in the order they called
+      , waiting : []
+      //being opened
+      , opening : 0
+      //being opened to be kept idle, rather than for a caller
+      , warming : 0
+      //set while replenishing waits to try again after failing to connect
+      , retryTimer : null
+    };
+  }
+  
+  return self.groups[connectionString];
+};
+
+Pool.prototype._size = function (group) {
+  return group.available.length
+    + group.used.length
+    + group.returning.length
+    + group.opening;
+};
+
 Pool.prototype.open = function (connectionString, callback) {
   var self = this
-    , db
+    , group
+    , waiter
     ;
 
-  //check to see if we already have a connection for this connection string
-  if (self.availablePool[connectionString] && self.availablePool[connectionString].length) {
-    db = self.availablePool[connectionString].shift()
-    self.usedPool[connectionString].push(db)
+  if (self.closed) {
+    return callback(new Error("[node-odbc] The pool is closed"));
+  }
+  
+  group = self._group(connectionString);
+  waiter = { callback : callback, timer : null, timedOut : false };
+  
+  if (self.acquireTimeout) {
+    waiter.timer = setTimeout(function () {
+      var index = group.waiting.indexOf(waiter);
+      
+      waiter.timedOut = true;
+      
+      if (index !== -1) {
+        group.waiting.splice(index, 1);
+      }
+      
+      callback(new Error("[node-odbc] Timed out waiting for a connection"));
+    }, self.acquireTimeout);
+  }
+  
+  group.waiting.push(waiter);
+  
+  self._dispense(group);
+};
 
-    callback(null, db);
+//hand out connections to waiting callers for as long as there are
+//connections to hand out, or room to open more
+Pool.prototype._dispense = function (group) {
+  var self = this
+    , waiter
+    ;
+  
+  while (group.waiting.length) {
+    waiter = group.waiting.shift();
+    
+    if (self.closed) {
+      clearTimeout(waiter.timer);
+      waiter.callback(new Error("[node-odbc] The pool is closed"));
+    }
+    else if (group.available.length) {
+      self._borrow(group, group.available.pop(), waiter);
+    }
+    else if (!self.max || self._size(group) < self.max) {
+      self._create(group, waiter);
+    }
+    else {
+      //wait for a connection to be returned
+      group.waiting.unshift(waiter);
+      
+      break;
+    }
   }
-  else {
-    db = new Database(self.options);
-    db.realClose = db.close;
-    
-    db.close = function (cb) {
-      //call back early, we can do the rest of this stuff after the client thinks
-      //that the connection is closed.
-      cb(null);
-      
-      
-      //close the connection for real
-      //this will kill any temp tables or anything that might be a security issue.
-      db.realClose(function () {
-         //remove this db from the usedPool
-         self.usedPool[connectionString].splice(self.usedPool[connectionString].indexOf(db), 1);
-
-        //re-open the connection using the connection string
-        db.open(connectionString, function (error) {
-          if (error) {
-            console.error(error);
-            return;
-          }
-          
-          //add this clean connection to the connection pool
-          self.availablePool[connectionString] = self.availablePool[connectionString] || [];
-          self.availablePool[connectionString].push(db);
-          exports.debug && console.dir(self);
-        });
+  
+  self._replenish(group);
+};
+
+Pool.prototype._connect = function (group, cb) {
+  var self = this
+    , db = new Database(self.options)
+    ;
+  
+  group.opening += 1;
+  
+  db.realClose = db.close;
+  
+  db.close = function (cb) {
+    self._release(group, db, cb);
+  };
+  
+  db.open(group.connectionString, function (error) {
+    exports.debug && console.log("odbc.js : pool[%s] : pool.db.open callback()", self.index);
+    
+    group.opening -= 1;
+    
+    if (self.closed) {
+      cb(error || new Error("[node-odbc] The pool is closed"));
+      
+      if (error) {
+        return self._closed();
+      }
+      
+      return db.realClose(function () {
+        self._closed();
       });
-    };
+    }
     
-    db.open(connectionString, function (error) {
-      exports.debug && console.log("odbc.js : pool[%s] : pool.db.open callback()", self.index);
+    cb(error, db);
+  });
+};
 
-      self.usedPool[connectionString] = self.usedPool[connectionString] || [];
-      self.usedPool[connectionString].push(db);
+Pool.prototype._create = function (group, waiter) {
+  var self = this;
+  
+  self._connect(group, function (error, db) {
+    if (error) {
+      if (!waiter.timedOut) {
+        clearTimeout(waiter.timer);
+        waiter.callback(error, db);
+      }
+      
+      //there is room for someone else to try
+      return self._dispense(group);
+    }
+    
+    group.used.push(db);
+    
+    self._give(group, db, waiter);
+  });
+};
 
-      callback(error, db);
+//open a connection to be kept idle until someone asks for one
+Pool.prototype._spawn = function (group, cb) {
+  var self = this;
+  
+  group.warming += 1;
+  
+  self._connect(group, function (error, db) {
+    group.warming -= 1;
+    
+    if (error) {
+      return cb(error);
+    }
+    
+    db.lastUsed = Date.now();
+    group.available.push(db);
+    
+    cb(null);
+    
+    self._dispense(group);
+  });
+};
+
+//open connections in the background until minIdle are idle and min are
+//open, or max are open. After failing to connect, wait retryDelay before 
+//trying again.
+Pool.prototype._replenish = function (group) {
+  var self = this;
+  
+  if ((!self.minIdle && !self.min) || self.closed || group.retryTimer) {
+    return;
+  }
+  
+  while ((group.available.length + group.warming < self.minIdle
+      || self._size(group) < self.min)
+    && (!self.max || self._size(group) < self.max)) {
+    self._spawn(group, function (error) {
+      if (!error || self.closed || group.retryTimer) {
+        return;
+      }
+      
+      exports.debug && console.log("odbc.js : pool[%s] : could not replenish: %s", self.index, error.message);
+      
+      group.retryTimer = setTimeout(function () {
+        group.retryTimer = null;
+        
+        self._replenish(group);
+      }, self.retryDelay);
+      
+      if (group.retryTimer.unref) {
+        group.retryTimer.unref();
+      }
     });
   }
 };
 
-Pool.prototype.close = function (callback) {
+//open count connections to connectionString at the same time and keep them
+//until they are asked for, so that the first callers of open() do not have
+//to wait for them to connect. Without count, minIdle are opened.
+Pool.prototype.warm = function (connectionString, count, callback) {
   var self = this
-    , required = 0
-    , received = 0
-    , connections
-    , key
+    , group
+    , remaining
+    , failed = null
     , x
     ;
+  
+  if (typeof(count) == 'function') {
+    callback = count;
+    count = null;
+  }
+  
+  callback = callback || function () {};
+  
+  if (self.closed) {
+    return callback(new Error("[node-odbc] The pool is closed"));
+  }
+  
+  group = self._group(connectionString);
+  count = (count || count === 0) ? count : self.minIdle;
+  
+  if (self.max) {
+    count = Math.min(count, self.max - self._size(group));
+  }
+  
+  if (count <= 0) {
+    return process.nextTick(function () {
+      callback(null);
+    });
+  }
+  
+  remaining = count;
+  
+  for (x = 0; x < count; x++) {
+    self._spawn(group, function (error) {
+      failed = failed || error;
+      
+      if (--remaining === 0) {
+        exports.debug && console.log("odbc.js : pool[%s] : warmed %s connections", self.index, count);
+        
+        callback(failed);
+        
+        self._replenish(group);
+      }
+    });
+  }
+};
 
-  exports.debug && console.log("odbc.js : pool[%s] : pool.close()", self.index);
-  //we set a timeout because a previous db.close() may
-  //have caused the a behind the scenes db.open() to prepare
-  //a new connection
-  setTimeout(function () {
-    //merge the available pool and the usedPool
-    var pools = {};
-
-    for (key in self.availablePool) {
-      pools[key] = (pools[key] || []).concat(self.availablePool[key]);
+Pool.prototype._borrow = function (group, db, waiter) {
+  var self = this;
+  
+  group.used.push(db);
+  
+  if (!self.validateOnBorrow) {
+    return self._give(group, db, waiter);
+  }
+  
+  self._validate(db, function (alive) {
+    var index;
+    
+    if (alive || self.closed) {
+      return self._give(group, db, waiter);
     }
-
-    for (key in self.usedPool) {
-      pools[key] = (pools[key] || []).concat(self.usedPool[key]);
+    
+    exports.debug && console.log("odbc.js : pool[%s] : discarding a dead connection", self.index);
+    
+    index = group.used.indexOf(db);
+    
+    if (index !== -1) {
+      group.used.splice(index, 1);
     }
+    
+    db.realClose(function () {});
+    
+    //the caller keeps their place in line
+    if (!waiter.timedOut) {
+      group.waiting.unshift(waiter);
+    }
+    
+    self._dispense(group);
+  });
+};
 
-    exports.debug && console.log("odbc.js : pool[%s] : pool.close() - setTimeout() callback", self.index);
-    exports.debug && console.dir(pools);
+Pool.prototype._validate = function (db, cb) {
+  var self = this;
+  
+  if (!db.connected) {
+    return cb(false);
+  }
+  
+  if (self.validationQuery) {
+    return db.query(self.validationQuery, function (err) {
+      cb(!err);
+    });
+  }
+  
+  db.conn.validate(function (err, alive) {
+    cb(!err && alive);
+  });
+};
 
-    if (Object.keys(pools).length == 0) {
-      return callback();
+Pool.prototype._give = function (group, db, waiter) {
+  var self = this;
+  
+  if (self.closed) {
+    clearTimeout(waiter.timer);
+    
+    if (!waiter.timedOut) {
+      waiter.callback(new Error("[node-odbc] The pool is closed"));
     }
+    
+    return;
+  }
+  
+  if (waiter.timedOut) {
+    //nobody wants it any more
+    return self._release(group, db);
+  }
+  
+  clearTimeout(waiter.timer);
+  waiter.callback(null, db);
+};
 
-    for (key in pools) {
-      connections = pools[key];
-      required += connections.length;
+//db.close() on a connection from the pool. The connection is reset rather
+//than closed, so that it can be handed out again without reconnecting.
+Pool.prototype._release = function (group, db, cb) {
+  var self = this
+    , index = group.used.indexOf(db)
+    ;
+  
+  //call back early, we can do the rest of this stuff after the client thinks
+  //that the connection is closed.
+  if (cb) cb(null);
+  
+  //closed twice, or closed along with the pool
+  if (index === -1) {
+    return;
+  }
+  
+  group.used.splice(index, 1);
 
-      exports.debug && console.log("odbc.js : pool[%s] : pool.close() - processing pools %s - connections: %s", self.index, key, connections.length);
+  if (!db.connected) {
+    return self._dispense(group);
+  }
 
-      for (x = 0 ; x < connections.length; x ++) {
-        (function (x) {
-          //call the realClose method to avoid
-          //automatically re-opening the connection
-          exports.debug && console.log("odbc.js : pool[%s] : pool.close() - calling realClose() for connection #%s", self.index, x);
+  group.returning.push(db);
+  
+  //after whatever the caller left running on it
+  db.queue.push(function (next) {
+    db.conn.reset(function (err) {
+      index = group.returning.indexOf(db);
+      
+      if (index === -1) {
+        //the pool was closed and is closing it
+        return next();
+      }
+      
+      group.returning.splice(index, 1);
+      
+      if (err) {
+        exports.debug && console.log("odbc.js : pool[%s] : could not reset connection: %s", self.index, err.message);
+        
+        next();
+        db.realClose(function () {});
+      }
+      else {
+        db.lastUsed = Date.now();
+        group.available.push(db);
+        
+        next();
+      }
+      
+      self._dispense(group);
+    });
+  });
+};
 
-          connections[x].realClose(function () {
-            exports.debug && console.log("odbc.js : pool[%s] : pool.close() - realClose() callback for connection #%s", self.index, x);
-            received += 1;
+//close connections that have not been used for idleTimeout, leaving at least
+//min open
+Pool.prototype._evict = function () {
+  var self = this
+    , now = Date.now()
+    , group
+    , key
+    ;
+  
+  for (key in self.groups) {
+    group = self.groups[key];
+    
+    //the ones that have been idle the longest are first
+    while (group.available.length > self.minIdle
+      && self._size(group) > self.min
+      && now - group.available[0].lastUsed >= self.idleTimeout) {
+      exports.debug && console.log("odbc.js : pool[%s] : closing an idle connection", self.index);
+      
+      group.available.shift().realClose(function () {});
+    }
+  }
+};
 
-            if (received === required) {
-              callback();
+Pool.prototype.close = function (callback) {
+  var self = this
+    , connections = []
+    , waiting = []
+    , group
+    , key
+    ;
 
-              //prevent mem leaks
-              self = null;
-              connections = null;
-              required = null;
-              received = null;
-              key = null;
+  exports.debug && console.log("odbc.js : pool[%s] : pool.close()", self.index);
+  
+  self.closed = true;
+  self.closeCallback = callback || null;
+  
+  clearInterval(self.evictTimer);
+  
+  for (key in self.groups) {
+    group = self.groups[key];
+    
+    clearTimeout(group.retryTimer);
+    group.retryTimer = null;
+    
+    connections = connections.concat(group.available, group.used, group.returning);
+    waiting = waiting.concat(group.waiting);
+    
+    //connections still being opened are closed once they are
+    self.closing += group.opening;
+    
+    group.available = [];
+    group.used = [];
+    group.returning = [];
+    group.waiting = [];
+  }
+  
+  waiting.forEach(function (waiter) {
+    clearTimeout(waiter.timer);
+    waiter.callback(new Error("[node-odbc] The pool is closed"));
+  });
+  
+  //and one for ourselves, so that we do not call back before we are done
+  self.closing += connections.length + 1;
+  
+  connections.forEach(function (db, x) {
+    exports.debug && console.log("odbc.js : pool[%s] : pool.close() - calling realClose() for connection #%s", self.index, x);
+    
+    //realClose is queued after anything still running on the connection,
+    //including a reset
+    db.realClose(function () {
+      self._closed();
+    });
+  });
+  
+  self._closed();
+};
 
-              return;
-            }
-          });
-        })(x);
-      }
-    }
-  }, 2000);
+Pool.prototype._closed = function () {
+  var self = this
+    , callback = self.closeCallback
+    ;
+  
+  self.closing -= 1;
+  
+  if (self.closing === 0 && callback) {
+    self.closeCallback = null;
+    
+    callback();
+  }
 };
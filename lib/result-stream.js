@@ -0,0 +1,121 @@
+var Readable = require("stream").Readable
+  , util = require("util")
+  ;
+
+module.exports = ResultStream;
+
+//Readable stream of the rows in an ODBCResult. Rows are read in batches of
+//result.fetchSize with fetchBatch(), which keeps one batch fetched ahead of
+//the one that is being consumed. Nothing more is fetched while the stream's
+//buffer is full.
+function ResultStream(result, options) {
+  var self = this;
+  
+  if (!(self instanceof ResultStream)) {
+    return new ResultStream(result, options);
+  }
+  
+  options = options || {};
+  
+  Readable.call(self, { 
+    objectMode : true, 
+    highWaterMark : options.highWaterMark || 16
+  });
+  
+  self.result = null;
+  self.fetching = false;
+  self.waiting = false;
+  self.destroyed = false;
+  self.onDestroy = null;
+  
+  if (result) {
+    self.setResult(result);
+  }
+}
+
+util.inherits(ResultStream, Readable);
+
+//the result may be attached after the stream is created, eg. by
+//Database.queryStream() once the query has been executed
+ResultStream.prototype.setResult = function (result) {
+  var self = this;
+  
+  self.result = result;
+  
+  if (self.waiting) {
+    self.waiting = false;
+    self._read();
+  }
+};
+
+ResultStream.prototype._read = function () {
+  var self = this;
+  
+  if (!self.result) {
+    self.waiting = true;
+    return;
+  }
+  
+  if (self.fetching) {
+    return;
+  }
+  
+  self.fetching = true;
+  
+  self.result.fetchBatch(function (err, rows) {
+    self.fetching = false;
+    
+    if (self.destroyed) {
+      return;
+    }
+    
+    if (err) {
+      return self.emit("error", err);
+    }
+    
+    if (!rows) {
+      return self.push(null);
+    }
+    
+    if (!Array.isArray(rows)) {
+      //a FETCH_COLUMNS batch is passed on as a single chunk
+      return self.push(rows);
+    }
+    
+    for (var x = 0; x < rows.length; x++) {
+      self.push(rows[x]);
+    }
+  });
+};
+
+//called by destroy(); whoever owns the result is told so it can close it
+ResultStream.prototype._destroy = function (err, cb) {
+  var self = this;
+  
+  self.destroyed = true;
+  
+  if (self.onDestroy) {
+    self.onDestroy();
+  }
+  
+  cb(err);
+};
+
+//streams before node 8 have no destroy()
+if (!Readable.prototype.destroy) {
+  ResultStream.prototype.destroy = function (err) {
+    var self = this;
+    
+    if (self.destroyed) {
+      return;
+    }
+    
+    self._destroy(err || null, function (err) {
+      if (err) {
+        self.emit("error", err);
+      }
+      
+      self.emit("close");
+    });
+  };
+}
@@ -79,6 +79,7 @@ pfnSQLFreeHandle        pSQLFreeHandle;
 pfnSQLFetchScroll       pSQLFetchScroll;
 pfnSQLColAttribute      pSQLColAttribute;
 pfnSQLSetConnectAttr    pSQLSetConnectAttr;
+pfnSQLGetConnectAttr    pSQLGetConnectAttr;
 pfnSQLDriverConnect     pSQLDriverConnect;
 pfnSQLAllocHandle       pSQLAllocHandle;
 pfnSQLRowCount          pSQLRowCount;
@@ -89,6 +90,8 @@ pfnSQLColumns           pSQLColumns;
 pfnSQLBindParameter     pSQLBindParameter;
 pfnSQLPrimaryKeys       pSQLPrimaryKeys;
 pfnSQLSetEnvAttr        pSQLSetEnvAttr  ;
+pfnSQLSetStmtAttr       pSQLSetStmtAttr;
+pfnSQLGetStmtAttr       pSQLGetStmtAttr;
 pfnSQLFreeConnect       pSQLFreeConnect;
 pfnSQLFreeEnv           pSQLFreeEnv;
 pfnSQLFreeStmt          pSQLFreeStmt;                      
@@ -101,6 +104,10 @@ pfnSQLDrivers           pSQLDrivers;
 pfnSQLDataSources       pSQLDataSources;
 pfnSQLGetInfo           pSQLGetInfo;
 pfnSQLMoreResults       pSQLMoreResults;
+pfnSQLParamData         pSQLParamData;
+pfnSQLPutData           pSQLPutData;
+pfnSQLNumParams         pSQLNumParams;
+pfnSQLDescribeParam     pSQLDescribeParam;
 
 //#define LOAD_ENTRY( hMod, Name ) (p##Name = (pfn##Name) GetProcAddress( (hMod), #Name ))
 #define LOAD_ENTRY( hMod, Name ) (p##Name = (pfn##Name) GetFunction( (hMod), #Name ))
@@ -149,8 +156,8 @@ BOOL DynLoadODBC( char* odbcModuleName )
 
   //Unused-> if (LOAD_ENTRY( hMod, SQLDataSources    )  )
 //#endif
-  //Unused-> if (LOAD_ENTRY( hMod, SQLBindCol        )  )
-  //Unused-> if (LOAD_ENTRY( hMod, SQLCancel         )  )
+  if (LOAD_ENTRY( hMod, SQLBindCol        )  )
+  if (LOAD_ENTRY( hMod, SQLCancel         )  )
   //Unused-> if (LOAD_ENTRY( hMod, SQLConnect       )  )
   //Unused-> if (LOAD_ENTRY( hMod, SQLDescribeCol    )  )
   if (LOAD_ENTRY( hMod, SQLDisconnect     )  )
@@ -163,6 +170,7 @@ BOOL DynLoadODBC( char* odbcModuleName )
   //Unused-> if (LOAD_ENTRY( hMod, SQLFetchScroll    )  )
   if (LOAD_ENTRY( hMod, SQLColAttribute   )  )
   if (LOAD_ENTRY( hMod, SQLSetConnectAttr )  )
+  if (LOAD_ENTRY( hMod, SQLGetConnectAttr )  )
   if (LOAD_ENTRY( hMod, SQLDriverConnect  )  )
   if (LOAD_ENTRY( hMod, SQLAllocHandle    )  )
   if (LOAD_ENTRY( hMod, SQLRowCount       )  )
@@ -173,10 +181,16 @@ BOOL DynLoadODBC( char* odbcModuleName )
   if (LOAD_ENTRY( hMod, SQLBindParameter  )  )
   //Unused-> if (LOAD_ENTRY( hMod, SQLPrimaryKeys)  )
   if (LOAD_ENTRY( hMod, SQLSetEnvAttr     )  )
+  if (LOAD_ENTRY( hMod, SQLSetStmtAttr    )  )
+  if (LOAD_ENTRY( hMod, SQLGetStmtAttr    )  )
   if (LOAD_ENTRY( hMod, SQLFreeStmt       )  )
   if (LOAD_ENTRY( hMod, SQLPrepare        )  )
   //Unused-> if (LOAD_ENTRY( hMod, SQLGetInfo        )  )
   if (LOAD_ENTRY( hMod, SQLBindParameter  )  )
+  if (LOAD_ENTRY( hMod, SQLParamData      )  )
+  if (LOAD_ENTRY( hMod, SQLPutData        )  )
+  if (LOAD_ENTRY( hMod, SQLNumParams      )  )
+  if (LOAD_ENTRY( hMod, SQLDescribeParam  )  )
   if (LOAD_ENTRY( hMod, SQLMoreResults    )
           ) {
 
@@ -34,12 +34,12 @@ typedef RETCODE (SQL_API * pfnSQLAllocStmt)(
   HSTMT  FAR *phstmt);
 
 typedef RETCODE (SQL_API * pfnSQLBindCol)(
-  HSTMT       hstmt,
-  UWORD       icol,
-  SWORD       fCType,
-  PTR         rgbValue,
-  SDWORD      cbValueMax,
-  SDWORD FAR *pcbValue);
+  SQLHSTMT       StatementHandle,
+  SQLUSMALLINT   ColumnNumber,
+  SQLSMALLINT    TargetType,
+  SQLPOINTER     TargetValuePtr,
+  SQLLEN         BufferLength,
+  SQLLEN *       StrLen_or_IndPtr);
 
 typedef RETCODE (SQL_API * pfnSQLCancel)(
   HSTMT       hstmt);
@@ -65,6 +65,11 @@ typedef RETCODE (SQL_API * pfnSQLSetConnectAttr)(
   SQLINTEGER Attribute, SQLPOINTER Value,
   SQLINTEGER StringLength);
 
+typedef RETCODE (SQL_API * pfnSQLGetConnectAttr)(
+  SQLHDBC ConnectionHandle,
+  SQLINTEGER Attribute, SQLPOINTER Value,
+  SQLINTEGER BufferLength, SQLINTEGER *StringLength);
+
 typedef RETCODE (SQL_API * pfnSQLDriverConnect)(    
   SQLHDBC            hdbc,
   SQLHWND            hwnd,
@@ -136,6 +141,16 @@ typedef RETCODE (SQL_API * pfnSQLSetEnvAttr)(
   SQLINTEGER Attribute, SQLPOINTER Value,
   SQLINTEGER StringLength);
 
+typedef RETCODE (SQL_API * pfnSQLSetStmtAttr)(
+  SQLHSTMT StatementHandle,
+  SQLINTEGER Attribute, SQLPOINTER Value,
+  SQLINTEGER StringLength);
+
+typedef RETCODE (SQL_API * pfnSQLGetStmtAttr)(
+  SQLHSTMT StatementHandle,
+  SQLINTEGER Attribute, SQLPOINTER Value,
+  SQLINTEGER BufferLength, SQLINTEGER *StringLength);
+
 
 typedef RETCODE (SQL_API * pfnSQLConnect)(
   HDBC        hdbc,
@@ -296,6 +311,27 @@ typedef RETCODE (SQL_API * pfnSQLGetInfo)(
 typedef RETCODE (SQL_API * pfnSQLMoreResults)(
   HSTMT       hstmt);
 
+typedef RETCODE (SQL_API * pfnSQLParamData)(
+  SQLHSTMT    StatementHandle,
+  SQLPOINTER *ValuePtrPtr);
+
+typedef RETCODE (SQL_API * pfnSQLPutData)(
+  SQLHSTMT    StatementHandle,
+  SQLPOINTER  DataPtr,
+  SQLLEN      StrLen_or_Ind);
+
+typedef RETCODE (SQL_API * pfnSQLNumParams)(
+  SQLHSTMT      StatementHandle,
+  SQLSMALLINT  *ParameterCountPtr);
+
+typedef RETCODE (SQL_API * pfnSQLDescribeParam)(
+  SQLHSTMT      StatementHandle,
+  SQLUSMALLINT  ParameterNumber,
+  SQLSMALLINT  *DataTypePtr,
+  SQLULEN      *ParameterSizePtr,
+  SQLSMALLINT  *DecimalDigitsPtr,
+  SQLSMALLINT  *NullablePtr);
+
 extern pfnSQLGetData            pSQLGetData;
 extern pfnSQLGetFunctions       pSQLGetFunctions;
 extern pfnSQLAllocConnect       pSQLAllocConnect;
@@ -318,6 +354,7 @@ extern pfnSQLFetchScroll        pSQLFetchScroll;
 extern pfnSQLFetchScroll        pSQLFetchScroll;
 extern pfnSQLColAttribute       pSQLColAttribute; 
 extern pfnSQLSetConnectAttr     pSQLSetConnectAttr;
+extern pfnSQLGetConnectAttr     pSQLGetConnectAttr;
 extern pfnSQLDriverConnect      pSQLDriverConnect;
 extern pfnSQLAllocHandle        pSQLAllocHandle;
 extern pfnSQLRowCount           pSQLRowCount;
@@ -329,6 +366,8 @@ extern pfnSQLColumns            pSQLColumns;
 // extern pfnSQLBindParameter      pSQLBindParameter;
 extern pfnSQLPrimaryKeys        pSQLPrimaryKeys;
 extern pfnSQLSetEnvAttr         pSQLSetEnvAttr;
+extern pfnSQLSetStmtAttr        pSQLSetStmtAttr;
+extern pfnSQLGetStmtAttr        pSQLGetStmtAttr;
 extern pfnSQLFreeConnect        pSQLFreeConnect;
 extern pfnSQLFreeEnv            pSQLFreeEnv;
 extern pfnSQLFreeStmt           pSQLFreeStmt;
@@ -344,6 +383,10 @@ extern pfnSQLDataSources        pSQLDataSources;
 extern pfnSQLBindParameter      pSQLBindParameter;
 extern pfnSQLGetInfo            pSQLGetInfo;
 extern pfnSQLMoreResults        pSQLMoreResults;
+extern pfnSQLParamData          pSQLParamData;
+extern pfnSQLPutData            pSQLPutData;
+extern pfnSQLNumParams          pSQLNumParams;
+extern pfnSQLDescribeParam      pSQLDescribeParam;
 
 BOOL DynLoadODBC( char* odbcModuleName );
 
@@ -355,6 +398,11 @@ BOOL DynLoadODBC( char* odbcModuleName );
 #define SQLError pSQLError
 #define SQLGetData pSQLGetData
 #define SQLMoreResults pSQLMoreResults
+#define SQLParamData pSQLParamData
+#define SQLPutData pSQLPutData
+#define SQLNumParams pSQLNumParams
+#define SQLDescribeParam pSQLDescribeParam
+#define SQLCancel pSQLCancel
 #define SQLPrepare pSQLPrepare
 #define SQLExecute pSQLExecute
 #define SQLGetDiagRec pSQLGetDiagRec
@@ -372,6 +420,7 @@ BOOL DynLoadODBC( char* odbcModuleName );
 #define SQLRowCount pSQLRowCount
 #define SQLNumResultCols pSQLNumResultCols
 #define SQLSetConnectAttr pSQLSetConnectAttr
+#define SQLGetConnectAttr pSQLGetConnectAttr
 #define SQLEndTran pSQLEndTran
 #define SQLExecDirect pSQLExecDirect
 #define SQLTables pSQLTables
@@ -379,5 +428,7 @@ BOOL DynLoadODBC( char* odbcModuleName );
 #define SQLBindParameter pSQLBindParameter
 #define SQLPrimaryKeys pSQLPrimaryKeys
 #define SQLSetEnvAttr pSQLSetEnvAttr
+#define SQLSetStmtAttr pSQLSetStmtAttr
+#define SQLGetStmtAttr pSQLGetStmtAttr
 #endif
 #endif // _SRC_DYNODBC_H_
@@ -16,6 +16,7 @@
 */
 
 #include <string.h>
+#include <math.h>
 #include <v8.h>
 #include <node.h>
 #include <node_version.h>
@@ -26,6 +27,7 @@
 #include "odbc_connection.h"
 #include "odbc_result.h"
 #include "odbc_statement.h"
+#include "odbc_worker_pool.h"
 
 #ifdef dynodbc
 #include "dynodbc.h"
@@ -42,6 +44,12 @@ uv_mutex_t ODBC::g_odbcMutex;
 uv_async_t ODBC::g_async;
 
 Persistent<Function> ODBC::constructor;
+Persistent<String> ODBC::OPTION_VALUE;
+Persistent<String> ODBC::OPTION_TYPE;
+Persistent<String> ODBC::OPTION_SIZE;
+Persistent<String> ODBC::OPTION_SCALE;
+Persistent<String> ODBC::OPTION_LENGTH;
+Persistent<String> ODBC::OPTION_STREAM;
 
 void ODBC::Init(v8::Handle<Object> exports) {
   DEBUG_PRINTF("ODBC::Init\n");
@@ -70,6 +78,41 @@ void ODBC::Init(v8::Handle<Object> exports) {
   constructor_template->Set(NanNew<String>("SQL_DESTROY"), NanNew<Number>(SQL_DESTROY), constant_attributes);
   constructor_template->Set(NanNew<String>("FETCH_ARRAY"), NanNew<Number>(FETCH_ARRAY), constant_attributes);
   NODE_ODBC_DEFINE_CONSTANT(constructor_template, FETCH_OBJECT);
+  NODE_ODBC_DEFINE_CONSTANT(constructor_template, FETCH_COLUMNS);
+  NODE_ODBC_DEFINE_CONSTANT(constructor_template, LOCK_GLOBAL);
+  NODE_ODBC_DEFINE_CONSTANT(constructor_template, LOCK_CONNECTION);
+  NODE_ODBC_DEFINE_CONSTANT(constructor_template, LOCK_NONE);
+  
+  //sql types for parameter descriptors
+  NODE_ODBC_DEFINE_CONSTANT(constructor_template, SQL_CHAR);
+  NODE_ODBC_DEFINE_CONSTANT(constructor_template, SQL_VARCHAR);
+  NODE_ODBC_DEFINE_CONSTANT(constructor_template, SQL_LONGVARCHAR);
+  NODE_ODBC_DEFINE_CONSTANT(constructor_template, SQL_WCHAR);
+  NODE_ODBC_DEFINE_CONSTANT(constructor_template, SQL_WVARCHAR);
+  NODE_ODBC_DEFINE_CONSTANT(constructor_template, SQL_WLONGVARCHAR);
+  NODE_ODBC_DEFINE_CONSTANT(constructor_template, SQL_DECIMAL);
+  NODE_ODBC_DEFINE_CONSTANT(constructor_template, SQL_NUMERIC);
+  NODE_ODBC_DEFINE_CONSTANT(constructor_template, SQL_BIT);
+  NODE_ODBC_DEFINE_CONSTANT(constructor_template, SQL_TINYINT);
+  NODE_ODBC_DEFINE_CONSTANT(constructor_template, SQL_SMALLINT);
+  NODE_ODBC_DEFINE_CONSTANT(constructor_template, SQL_INTEGER);
+  NODE_ODBC_DEFINE_CONSTANT(constructor_template, SQL_BIGINT);
+  NODE_ODBC_DEFINE_CONSTANT(constructor_template, SQL_REAL);
+  NODE_ODBC_DEFINE_CONSTANT(constructor_template, SQL_FLOAT);
+  NODE_ODBC_DEFINE_CONSTANT(constructor_template, SQL_DOUBLE);
+  NODE_ODBC_DEFINE_CONSTANT(constructor_template, SQL_TYPE_DATE);
+  NODE_ODBC_DEFINE_CONSTANT(constructor_template, SQL_TYPE_TIME);
+  NODE_ODBC_DEFINE_CONSTANT(constructor_template, SQL_TYPE_TIMESTAMP);
+  NODE_ODBC_DEFINE_CONSTANT(constructor_template, SQL_BINARY);
+  NODE_ODBC_DEFINE_CONSTANT(constructor_template, SQL_VARBINARY);
+  NODE_ODBC_DEFINE_CONSTANT(constructor_template, SQL_LONGVARBINARY);
+  
+  NanAssignPersistent(OPTION_VALUE, NanNew("value"));
+  NanAssignPersistent(OPTION_TYPE, NanNew("type"));
+  NanAssignPersistent(OPTION_SIZE, NanNew("size"));
+  NanAssignPersistent(OPTION_SCALE, NanNew("scale"));
+  NanAssignPersistent(OPTION_LENGTH, NanNew("length"));
+  NanAssignPersistent(OPTION_STREAM, NanNew("stream"));
   
   // Prototype Methods
   NODE_SET_PROTOTYPE_METHOD(constructor_template, "createConnection", CreateConnection);
@@ -180,7 +223,7 @@ NAN_METHOD(ODBC::CreateConnection) {
 
   work_req->data = data;
   
-  uv_queue_work(uv_default_loop(), work_req, UV_CreateConnection, (uv_after_work_cb)UV_AfterCreateConnection);
+  ODBCWorkerPool::Queue(NULL, work_req, UV_CreateConnection, (uv_after_work_cb)UV_AfterCreateConnection);
 
   dbo->Ref();
 
@@ -278,6 +321,22 @@ NAN_METHOD(ODBC::CreateConnectionSync) {
  */
 
 Column* ODBC::GetColumns(SQLHSTMT hStmt, short* colCount) {
+  Column* columns = DescribeColumns(hStmt, colCount);
+  
+  CreateColumnKeys(columns, colCount);
+  
+  return columns;
+}
+
+/*
+ * DescribeColumns
+ * 
+ * Everything GetColumns does apart from creating the property names. This
+ * does not touch v8 so it can be called on the thread pool; call 
+ * CreateColumnKeys on the main thread before making any rows.
+ */
+
+Column* ODBC::DescribeColumns(SQLHSTMT hStmt, short* colCount) {
   SQLRETURN ret;
   SQLSMALLINT buflen;
 
@@ -318,6 +377,8 @@ Column* ODBC::GetColumns(SQLHSTMT hStmt, short* colCount) {
     //store the len attribute
     columns[i].len = buflen;
     
+    columns[i].key = NULL;
+    
     //get the column type and store it directly in column[i].type
     ret = SQLColAttribute( hStmt,
                            columns[i].index,
@@ -326,11 +387,109 @@ Column* ODBC::GetColumns(SQLHSTMT hStmt, short* colCount) {
                            0,
                            NULL,
                            &columns[i].type);
+    
+    //get the column size; for character data this is the length in characters
+    columns[i].size = 0;
+    
+    ret = SQLColAttribute( hStmt,
+                           columns[i].index,
+                           SQL_DESC_LENGTH,
+                           NULL,
+                           0,
+                           NULL,
+                           &columns[i].size);
+    
+    //work out the C type, the decoder for it and the per-row buffer size 
+    //that would be needed to bind this column for a block fetch. A bindSize
+    //of 0 means that the column can only be retrieved with SQLGetData.
+    switch ((int) columns[i].type) {
+      case SQL_INTEGER :
+      case SQL_SMALLINT :
+      case SQL_TINYINT :
+        columns[i].cType = SQL_C_SLONG;
+        columns[i].decode = DecodeInteger;
+        columns[i].bindSize = sizeof(int32_t);
+        break;
+      case SQL_NUMERIC :
+      case SQL_DECIMAL :
+      case SQL_BIGINT :
+      case SQL_FLOAT :
+      case SQL_REAL :
+      case SQL_DOUBLE :
+        columns[i].cType = SQL_C_DOUBLE;
+        columns[i].decode = DecodeDouble;
+        columns[i].bindSize = sizeof(double);
+        break;
+      case SQL_DATETIME :
+      case SQL_TIMESTAMP :
+        columns[i].cType = SQL_C_TYPE_TIMESTAMP;
+        columns[i].decode = DecodeTimestamp;
+        columns[i].bindSize = sizeof(SQL_TIMESTAMP_STRUCT);
+        break;
+      case SQL_BIT :
+        columns[i].cType = SQL_C_CHAR;
+        columns[i].decode = DecodeBit;
+        columns[i].bindSize = 8;
+        break;
+      case SQL_LONGVARCHAR :
+      case SQL_WLONGVARCHAR :
+        //long data can not be sized up front
+        columns[i].cType = SQL_C_TCHAR;
+        columns[i].decode = DecodeString;
+        columns[i].bindSize = 0;
+        break;
+      case SQL_LONGVARBINARY :
+        columns[i].cType = SQL_C_BINARY;
+        columns[i].decode = DecodeBinary;
+        columns[i].bindSize = 0;
+        break;
+      case SQL_BINARY :
+      case SQL_VARBINARY :
+        columns[i].cType = SQL_C_BINARY;
+        columns[i].decode = DecodeBinary;
+        columns[i].bindSize = columns[i].size;
+        break;
+      default :
+        columns[i].cType = SQL_C_TCHAR;
+        columns[i].decode = DecodeString;
+#ifdef UNICODE
+        columns[i].bindSize = (columns[i].size + 1) * sizeof(uint16_t);
+#else
+        //leave room for multi-byte characters
+        columns[i].bindSize = (columns[i].size * 4) + 1;
+#endif
+    }
+    
+    if ((columns[i].cType == SQL_C_TCHAR || columns[i].cType == SQL_C_BINARY)
+        && (columns[i].size <= 0 || columns[i].bindSize > MAX_BIND_COLUMN_SIZE)) {
+      columns[i].bindSize = 0;
+    }
   }
   
   return columns;
 }
 
+/*
+ * CreateColumnKeys
+ * 
+ * Create the property name of each column once instead of once per row.
+ */
+
+void ODBC::CreateColumnKeys(Column* columns, short* colCount) {
+  for (int i = 0; i < *colCount; i++) {
+    if (columns[i].key != NULL) {
+      continue;
+    }
+    
+    columns[i].key = new Persistent<String>();
+#ifdef UNICODE
+    NanAssignPersistent(*columns[i].key, NanNew((uint16_t *) columns[i].name));
+#else
+    NanAssignPersistent(*columns[i].key, NanNew((const char *) columns[i].name));
+#endif
+  }
+}
+
 /*
  * FreeColumns
  */
@@ -338,6 +497,11 @@ Column* ODBC::GetColumns(SQLHSTMT hStmt, short* colCount) {
 void ODBC::FreeColumns(Column* columns, short* colCount) {
   for(int i = 0; i < *colCount; i++) {
       delete [] columns[i].name;
+      
+      if (columns[i].key != NULL) {
+        NanDisposePersistent(*columns[i].key);
+        delete columns[i].key;
+      }
   }
 
   delete [] columns;
@@ -346,271 +510,239 @@ void ODBC::FreeColumns(Column* columns, short* colCount) {
 }
 
 /*
- * GetColumnValue
+ * Column decoders
+ * 
+ * GetColumns picks one of these for each column so that turning a value into
+ * a javascript value does not have to look at the column type again.
  */
 
-Handle<Value> ODBC::GetColumnValue( SQLHSTMT hStmt, Column column, 
-                                        uint16_t* buffer, int bufferLength) {
-  NanEscapableScope();
-  SQLLEN len = 0;
+Local<Value> ODBC::DecodeInteger(char* value, SQLLEN len) {
+  return NanNew<Integer>(*(int32_t *) value);
+}
 
-  //reset the buffer
-  buffer[0] = '\0';
+Local<Value> ODBC::DecodeDouble(char* value, SQLLEN len) {
+  return NanNew<Number>(*(double *) value);
+}
 
-  //TODO: SQLGetData can supposedly return multiple chunks, need to do this to 
-  //retrieve large fields
-  int ret; 
+Local<Value> ODBC::DecodeTimestamp(char* value, SQLLEN len) {
+  SQL_TIMESTAMP_STRUCT* odbcTime = (SQL_TIMESTAMP_STRUCT *) value;
+  struct tm timeInfo;
   
-  switch ((int) column.type) {
-    case SQL_INTEGER : 
-    case SQL_SMALLINT :
-    case SQL_TINYINT : {
-        int32_t value = 0;
-        
-        ret = SQLGetData(
-          hStmt, 
-          column.index, 
-          SQL_C_SLONG,
-          &value, 
-          sizeof(value), 
-          &len);
-        
-        DEBUG_PRINTF("ODBC::GetColumnValue - Integer: index=%i name=%s type=%i len=%i ret=%i val=%li\n", 
-                    column.index, column.name, column.type, len, ret, value);
-        
-        if (len == SQL_NULL_DATA) {
-          return NanEscapeScope(NanNull());
-        }
-        else {
-          return NanEscapeScope(NanNew<Integer>(value));
-        }
-      }
-      break;
-    case SQL_NUMERIC :
-    case SQL_DECIMAL :
-    case SQL_BIGINT :
-    case SQL_FLOAT :
-    case SQL_REAL :
-    case SQL_DOUBLE : {
-        double value;
-        
-        ret = SQLGetData(
-          hStmt, 
-          column.index, 
-          SQL_C_DOUBLE,
-          &value, 
-          sizeof(value), 
-          &len);
-        
-         DEBUG_PRINTF("ODBC::GetColumnValue - Number: index=%i name=%s type=%i len=%i ret=%i val=%f\n", 
-                    column.index, column.name, column.type, len, ret, value);
-        
-        if (len == SQL_NULL_DATA) {
-          return NanEscapeScope(NanNull());
-          //return Null();
-        }
-        else {
-          return NanEscapeScope(NanNew<Number>(value));
-          //return Number::New(value);
-        }
-      }
-      break;
-    case SQL_DATETIME :
-    case SQL_TIMESTAMP : {
-      //I am not sure if this is locale-safe or cross database safe, but it 
-      //works for me on MSSQL
-#ifdef _WIN32
-      struct tm timeInfo = {};
-
-      ret = SQLGetData(
-        hStmt, 
-        column.index, 
-        SQL_C_CHAR,
-        (char *) buffer, 
-        bufferLength, 
-        &len);
-
-      DEBUG_PRINTF("ODBC::GetColumnValue - W32 Timestamp: index=%i name=%s type=%i len=%i\n", 
-                    column.index, column.name, column.type, len);
-
-      if (len == SQL_NULL_DATA) {
-        return NanEscapeScope(NanNull());
-        //return Null();
-      }
-      else {
-        if (strptime((char *) buffer, "%Y-%m-%d %H:%M:%S", &timeInfo)) {
-          //a negative value means that mktime() should use timezone information
-          //and system databases to attempt to determine whether DST is in effect
-          //at the specified time.
-          timeInfo.tm_isdst = -1;
-          
-          //return NanEscapeScope(Date::New(Isolate::GetCurrent(), (double(mktime(&timeInfo)) * 1000));
-          return NanEscapeScope(NanNew<Date>(double(mktime(&timeInfo)) * 1000));
-        }
-        else {
-          return NanEscapeScope(NanNew((char *)buffer));
-        }
-      }
-#else
-      struct tm timeInfo = { 
-        tm_sec : 0
-        , tm_min : 0
-        , tm_hour : 0
-        , tm_mday : 0
-        , tm_mon : 0
-        , tm_year : 0
-        , tm_wday : 0
-        , tm_yday : 0
-        , tm_isdst : 0
-        , tm_gmtoff : 0
-        , tm_zone : 0
-      };
-
-      SQL_TIMESTAMP_STRUCT odbcTime;
-      
-      ret = SQLGetData(
-        hStmt, 
-        column.index, 
-        SQL_C_TYPE_TIMESTAMP,
-        &odbcTime, 
-        bufferLength, 
-        &len);
-
-      DEBUG_PRINTF("ODBC::GetColumnValue - Unix Timestamp: index=%i name=%s type=%i len=%i\n", 
-                    column.index, column.name, column.type, len);
-
-      if (len == SQL_NULL_DATA) {
-        return NanEscapeScope(NanNull());
-        //return Null();
-      }
-      else {
-        timeInfo.tm_year = odbcTime.year - 1900;
-        timeInfo.tm_mon = odbcTime.month - 1;
-        timeInfo.tm_mday = odbcTime.day;
-        timeInfo.tm_hour = odbcTime.hour;
-        timeInfo.tm_min = odbcTime.minute;
-        timeInfo.tm_sec = odbcTime.second;
-
-        //a negative value means that mktime() should use timezone information 
-        //and system databases to attempt to determine whether DST is in effect 
-        //at the specified time.
-        timeInfo.tm_isdst = -1;
-#ifdef TIMEGM
-        return NanEscapeScope(NanNew<Date>((double(timegm(&timeInfo)) * 1000)
-                          + (odbcTime.fraction / 1000000)));
+  memset(&timeInfo, 0, sizeof(timeInfo));
+  
+  timeInfo.tm_year = odbcTime->year - 1900;
+  timeInfo.tm_mon = odbcTime->month - 1;
+  timeInfo.tm_mday = odbcTime->day;
+  timeInfo.tm_hour = odbcTime->hour;
+  timeInfo.tm_min = odbcTime->minute;
+  timeInfo.tm_sec = odbcTime->second;
+  
+  //a negative value means that mktime() should use timezone information 
+  //and system databases to attempt to determine whether DST is in effect 
+  //at the specified time.
+  timeInfo.tm_isdst = -1;
+#if defined(_WIN32)
+  return NanNew<Date>((double(mktime(&timeInfo)) * 1000)
+                      + (odbcTime->fraction / 1000000));
+#elif defined(TIMEGM)
+  return NanNew<Date>((double(timegm(&timeInfo)) * 1000)
+                      + (odbcTime->fraction / 1000000));
 #else
-        return NanEscapeScope(NanNew<Date>((double(timelocal(&timeInfo)) * 1000)
-                          + (odbcTime.fraction / 1000000)));
+  return NanNew<Date>((double(timelocal(&timeInfo)) * 1000)
+                      + (odbcTime->fraction / 1000000));
 #endif
-        //return Date::New((double(timegm(&timeInfo)) * 1000) 
-        //                  + (odbcTime.fraction / 1000000));
-      }
+}
+
+//the reverse of DecodeTimestamp, for binding a Date as a parameter
+void ODBC::EncodeTimestamp(Local<Value> value, SQL_TIMESTAMP_STRUCT* timestamp) {
+  double ms = value->NumberValue();
+  double seconds = floor(ms / 1000);
+  time_t time = (time_t) seconds;
+  struct tm timeInfo;
+  
+#if defined(_WIN32)
+  localtime_s(&timeInfo, &time);
+#elif defined(TIMEGM)
+  gmtime_r(&time, &timeInfo);
+#else
+  localtime_r(&time, &timeInfo);
 #endif
-    } break;
-    case SQL_BIT :
-      //again, i'm not sure if this is cross database safe, but it works for 
-      //MSSQL
-      ret = SQLGetData(
-        hStmt, 
-        column.index, 
-        SQL_C_CHAR,
-        (char *) buffer, 
-        bufferLength, 
-        &len);
-
-      DEBUG_PRINTF("ODBC::GetColumnValue - Bit: index=%i name=%s type=%i len=%i\n", 
-                    column.index, column.name, column.type, len);
-
-      if (len == SQL_NULL_DATA) {
-        return NanEscapeScope(NanNull());
-      }
-      else {
-        return NanEscapeScope(NanNew((*buffer == '0') ? false : true));
-      }
-    default :
-      Local<String> str;
-      int count = 0;
-      
-      do {
-        ret = SQLGetData(
-          hStmt,
-          column.index,
-          SQL_C_TCHAR,
-          (char *) buffer,
-          bufferLength,
-          &len);
-
-        DEBUG_PRINTF("ODBC::GetColumnValue - String: index=%i name=%s type=%i len=%i value=%s ret=%i bufferLength=%i\n", 
-                      column.index, column.name, column.type, len,(char *) buffer, ret, bufferLength);
-
-        if (len == SQL_NULL_DATA && str.IsEmpty()) {
-          return NanEscapeScope(NanNull());
-          //return Null();
-        }
-        
-        if (SQL_NO_DATA == ret) {
-          //we have captured all of the data
-          //double check that we have some data else return null
-          if (str.IsEmpty()){
-            return NanEscapeScope(NanNull());
-          }
+  
+  timestamp->year = timeInfo.tm_year + 1900;
+  timestamp->month = timeInfo.tm_mon + 1;
+  timestamp->day = timeInfo.tm_mday;
+  timestamp->hour = timeInfo.tm_hour;
+  timestamp->minute = timeInfo.tm_min;
+  timestamp->second = timeInfo.tm_sec;
+  timestamp->fraction = (SQLUINTEGER) (ms - (seconds * 1000)) * 1000000;
+}
 
-          break;
-        }
-        else if (SQL_SUCCEEDED(ret)) {
-          //we have not captured all of the data yet
-          
-          if (count == 0) {
-            //no concatenation required, this is our first pass
+Local<Value> ODBC::DecodeBit(char* value, SQLLEN len) {
+  //again, i'm not sure if this is cross database safe, but it works for 
+  //MSSQL
+  return NanNew((*value == '0') ? false : true);
+}
+
+Local<Value> ODBC::DecodeBinary(char* value, SQLLEN len) {
+  return NanNewBufferHandle(value, (uint32_t) len);
+}
+
+//frees the malloc'd memory of a value handed over to a Buffer, once the
+//Buffer has been collected
+void ODBC::FreeBufferData(char* data, void* hint) {
+  free(data);
+}
+
+Local<Value> ODBC::DecodeString(char* value, SQLLEN len) {
 #ifdef UNICODE
-            str = NanNew((uint16_t*) buffer);
+  return NanNew((uint16_t *) value, (int) (len / sizeof(uint16_t)));
 #else
-            str = NanNew((char *) buffer);
+  return NanNew((char *) value, (int) len);
 #endif
-          }
-          else {
-            //we need to concatenate
+}
+
+/*
+ * GetColumnValue
+ */
+
+Handle<Value> ODBC::GetColumnValue( SQLHSTMT hStmt, Column column, 
+                                        uint16_t* buffer, int bufferLength) {
+  NanEscapableScope();
+  SQLLEN len = 0;
+
+  //reset the buffer
+  buffer[0] = '\0';
+
+  SQLRETURN ret;
+  
+  //binary data is read into a buffer of its own which is handed over to 
+  //the Buffer object as it is, to be freed when the Buffer is collected
+  if (column.cType == SQL_C_BINARY) {
+    char* value;
+    
+    ret = GetLongData(hStmt, column, &value, &len);
+    
+    if (!SQL_SUCCEEDED(ret)) {
+      NanThrowError(ODBC::GetSQLError(
+         SQL_HANDLE_STMT,
+         hStmt,
+         (char *) "[node-odbc] Error in ODBC::GetColumnValue"
+       ));
+      return NanEscapeScope(NanUndefined());
+    }
+    
+    if (len == SQL_NULL_DATA) {
+      return NanEscapeScope(NanNull());
+    }
+    
+    return NanEscapeScope(NanNewBufferHandle(value, len, FreeBufferData, NULL));
+  }
+  
+  //everything but character data is a fixed size and can be decoded from 
+  //a single call to SQLGetData
+  if (column.cType != SQL_C_TCHAR) {
+    ret = SQLGetData(
+      hStmt, 
+      column.index, 
+      column.cType,
+      (char *) buffer, 
+      bufferLength, 
+      &len);
+    
+    DEBUG_PRINTF("ODBC::GetColumnValue - Fixed: index=%i name=%s type=%i len=%i ret=%i\n", 
+                 column.index, column.name, column.type, len, ret);
+    
+    if (len == SQL_NULL_DATA || ret == SQL_NO_DATA) {
+      return NanEscapeScope(NanNull());
+    }
+    
+    return NanEscapeScope(column.decode((char *) buffer, len));
+  }
+  
+  //character data is read into the buffer we were given when it fits. When
+  //it does not the first call tells us how long the value is, so that it 
+  //can be read into one allocation and made into a string once.
 #ifdef UNICODE
-            str = String::Concat(str, NanNew((uint16_t*) buffer));
+  SQLLEN terminator = sizeof(uint16_t);
 #else
-            str = String::Concat(str, NanNew((char *) buffer));
+  SQLLEN terminator = sizeof(char);
 #endif
-          }
-          
-          //if len is zero let's break out of the loop now and not attempt to
-          //call SQLGetData again. The specific reason for this is because
-          //some ODBC drivers may not correctly report SQL_NO_DATA the next
-          //time around causing an infinite loop here
-          if (len == 0) {
-            break;
-          }
-          
-          count += 1;
-        }
-        else {
-          //an error has occured
-          //possible values for ret are SQL_ERROR (-1) and SQL_INVALID_HANDLE (-2)
-
-          //If we have an invalid handle, then stuff is way bad and we should abort
-          //immediately. Memory errors are bound to follow as we must be in an
-          //inconsisant state.
-          assert(ret != SQL_INVALID_HANDLE);
-
-          //Not sure if throwing here will work out well for us but we can try
-          //since we should have a valid handle and the error is something we 
-          //can look into
-          NanThrowError(ODBC::GetSQLError(
-             SQL_HANDLE_STMT,
-             hStmt,
-             (char *) "[node-odbc] Error in ODBC::GetColumnValue"
-           ));
-          return NanEscapeScope(NanUndefined());
-          break;
-        }
-      } while (true);
+  
+  ret = SQLGetData(
+    hStmt,
+    column.index,
+    SQL_C_TCHAR,
+    (char *) buffer,
+    bufferLength,
+    &len);
+  
+  DEBUG_PRINTF("ODBC::GetColumnValue - String: index=%i name=%s type=%i len=%i ret=%i bufferLength=%i\n", 
+                column.index, column.name, column.type, len, ret, bufferLength);
+  
+  if (ret == SQL_NO_DATA || (SQL_SUCCEEDED(ret) && len == SQL_NULL_DATA)) {
+    return NanEscapeScope(NanNull());
+  }
+  
+  if (SQL_SUCCEEDED(ret) 
+      && len != SQL_NO_TOTAL && len <= bufferLength - terminator) {
+    return NanEscapeScope(column.decode((char *) buffer, len));
+  }
+  
+  if (SQL_SUCCEEDED(ret)) {
+    SQLLEN total = ((bufferLength - terminator) / terminator) * terminator;
+    SQLLEN capacity = (len == SQL_NO_TOTAL) ? bufferLength * 2 : len + terminator;
+    char* value = (char *) malloc(capacity);
+    
+    memcpy(value, buffer, total);
+    
+    ret = ReadLongData(hStmt, column, &value, capacity, total, &len);
+    
+    if (SQL_SUCCEEDED(ret)) {
+      Local<Value> str = column.decode(value, len);
+      
+      free(value);
       
       return NanEscapeScope(str);
+    }
+  }
+  
+  //an error has occured
+  //possible values for ret are SQL_ERROR (-1) and SQL_INVALID_HANDLE (-2)
+
+  //If we have an invalid handle, then stuff is way bad and we should abort
+  //immediately. Memory errors are bound to follow as we must be in an
+  //inconsisant state.
+  assert(ret != SQL_INVALID_HANDLE);
+
+  //Not sure if throwing here will work out well for us but we can try
+  //since we should have a valid handle and the error is something we 
+  //can look into
+  NanThrowError(ODBC::GetSQLError(
+     SQL_HANDLE_STMT,
+     hStmt,
+     (char *) "[node-odbc] Error in ODBC::GetColumnValue"
+   ));
+  return NanEscapeScope(NanUndefined());
+}
+
+/*
+ * GetRecordTemplate
+ * 
+ * An object with every column of the result set set to null. Rows are made
+ * by cloning it so that they all share one hidden class and the property
+ * names are not looked up again for every row.
+ */
+
+Local<Object> ODBC::GetRecordTemplate ( Column* columns, short* colCount) {
+  NanEscapableScope();
+  
+  Local<Object> tuple = NanNew<Object>();
+  
+  for(int i = 0; i < *colCount; i++) {
+    tuple->Set( NanNew(*columns[i].key), NanNull());
   }
+  
+  return NanEscapeScope(tuple);
 }
 
 /*
@@ -619,19 +751,15 @@ Handle<Value> ODBC::GetColumnValue( SQLHSTMT hStmt, Column column,
 
 Local<Object> ODBC::GetRecordTuple ( SQLHSTMT hStmt, Column* columns, 
                                          short* colCount, uint16_t* buffer,
-                                         int bufferLength) {
+                                         int bufferLength, 
+                                         Local<Object> recordTemplate) {
   NanEscapableScope();
   
-  Local<Object> tuple = NanNew<Object>();
+  Local<Object> tuple = recordTemplate->Clone();
         
   for(int i = 0; i < *colCount; i++) {
-#ifdef UNICODE
-    tuple->Set( NanNew((uint16_t *) columns[i].name),
+    tuple->Set( NanNew(*columns[i].key),
                 GetColumnValue( hStmt, columns[i], buffer, bufferLength));
-#else
-    tuple->Set( NanNew((const char *) columns[i].name),
-                GetColumnValue( hStmt, columns[i], buffer, bufferLength));
-#endif
   }
   
   return NanEscapeScope(tuple);
@@ -657,108 +785,1650 @@ Handle<Value> ODBC::GetRecordArray ( SQLHSTMT hStmt, Column* columns,
 }
 
 /*
- * GetParametersFromArray
+ * AllocRowBlock
+ * 
+ * Allocate storage for up to rowCapacity rows. When the block is to be bound
+ * with SQLBindCol every column is stored inline at its bindSize; otherwise
+ * character and binary data is read with SQLGetData into a separate 
+ * allocation per value.
  */
 
-Parameter* ODBC::GetParametersFromArray (Local<Array> values, int *paramCount) {
-  DEBUG_PRINTF("ODBC::GetParametersFromArray\n");
-  *paramCount = values->Length();
+RowBlock* ODBC::AllocRowBlock(Column* columns, short colCount, 
+                              int rowCapacity, bool bound) {
+  DEBUG_PRINTF("ODBC::AllocRowBlock colCount=%i rowCapacity=%i bound=%i\n", 
+               colCount, rowCapacity, bound);
   
-  Parameter* params = NULL;
+  RowBlock* block = (RowBlock *) calloc(1, sizeof(RowBlock));
   
-  if (*paramCount > 0) {
-    params = (Parameter *) malloc(*paramCount * sizeof(Parameter));
-  }
+  block->colCount = colCount;
+  block->rowCapacity = rowCapacity;
+  block->rowCount = 0;
+  block->bound = bound;
+  block->widths = (SQLLEN *) calloc(colCount, sizeof(SQLLEN));
+  block->values = (char **) calloc(colCount, sizeof(char *));
+  block->lengths = (SQLLEN **) calloc(colCount, sizeof(SQLLEN *));
   
-  for (int i = 0; i < *paramCount; i++) {
-    Local<Value> value = values->Get(i);
+  //one contiguous array of values and one of length indicators per column
+  for (int i = 0; i < colCount; i++) {
+    if (bound || (columns[i].cType != SQL_C_TCHAR && columns[i].cType != SQL_C_BINARY)) {
+      block->widths[i] = columns[i].bindSize;
+      block->values[i] = (char *) malloc(columns[i].bindSize * rowCapacity);
+    }
+    else {
+      block->widths[i] = 0;
+      block->values[i] = (char *) calloc(rowCapacity, sizeof(char *));
+    }
     
-    params[i].ColumnSize       = 0;
-    params[i].StrLen_or_IndPtr = SQL_NULL_DATA;
-    params[i].BufferLength     = 0;
-    params[i].DecimalDigits    = 0;
+    block->lengths[i] = (SQLLEN *) malloc(sizeof(SQLLEN) * rowCapacity);
+  }
+  
+  return block;
+}
 
-    DEBUG_PRINTF("ODBC::GetParametersFromArray - &param[%i].length = %X\n",
-                 i, &params[i].StrLen_or_IndPtr);
+/*
+ * ResetRowBlock
+ * 
+ * Release any per value allocations so the block can be filled again.
+ */
 
-    if (value->IsString()) {
-      Local<String> string = value->ToString();
-      int length = string->Length();
+void ODBC::ResetRowBlock(RowBlock* block) {
+  for (int i = 0; i < block->colCount; i++) {
+    if (block->widths[i] == 0) {
+      char **pointers = (char **) block->values[i];
       
-      params[i].ValueType         = SQL_C_TCHAR;
-      params[i].ColumnSize        = 0; //SQL_SS_LENGTH_UNLIMITED 
-#ifdef UNICODE
-      params[i].ParameterType     = SQL_WVARCHAR;
-      params[i].BufferLength      = (length * sizeof(uint16_t)) + sizeof(uint16_t);
-#else
-      params[i].ParameterType     = SQL_VARCHAR;
-      params[i].BufferLength      = string->Utf8Length() + 1;
-#endif
-      params[i].ParameterValuePtr = malloc(params[i].BufferLength);
-      params[i].StrLen_or_IndPtr  = SQL_NTS;//params[i].BufferLength;
+      for (int row = 0; row < block->rowCapacity; row++) {
+        free(pointers[row]);
+        pointers[row] = NULL;
+      }
+    }
+  }
+  
+  block->rowCount = 0;
+}
 
-#ifdef UNICODE
-      string->Write((uint16_t *) params[i].ParameterValuePtr);
-#else
-      string->WriteUtf8((char *) params[i].ParameterValuePtr);
-#endif
+/*
+ * FreeRowBlock
+ */
 
-      DEBUG_PRINTF("ODBC::GetParametersFromArray - IsString(): params[%i] c_type=%i type=%i buffer_length=%i size=%i length=%i value=%s\n",
-                    i, params[i].ValueType, params[i].ParameterType,
-                    params[i].BufferLength, params[i].ColumnSize, params[i].StrLen_or_IndPtr, 
-                    (char*) params[i].ParameterValuePtr);
-    }
-    else if (value->IsNull()) {
-      params[i].ValueType = SQL_C_DEFAULT;
-      params[i].ParameterType   = SQL_VARCHAR;
-      params[i].StrLen_or_IndPtr = SQL_NULL_DATA;
+void ODBC::FreeRowBlock(RowBlock* block) {
+  if (block == NULL) {
+    return;
+  }
+  
+  ResetRowBlock(block);
+  
+  for (int i = 0; i < block->colCount; i++) {
+    free(block->values[i]);
+    free(block->lengths[i]);
+  }
+  
+  free(block->widths);
+  free(block->values);
+  free(block->lengths);
+  free(block);
+}
 
-      DEBUG_PRINTF("ODBC::GetParametersFromArray - IsNull(): params[%i] c_type=%i type=%i buffer_length=%i size=%i length=%i\n",
-                   i, params[i].ValueType, params[i].ParameterType,
-                   params[i].BufferLength, params[i].ColumnSize, params[i].StrLen_or_IndPtr);
-    }
-    else if (value->IsInt32()) {
-      int64_t  *number = new int64_t(value->IntegerValue());
-      params[i].ValueType = SQL_C_SBIGINT;
-      params[i].ParameterType   = SQL_BIGINT;
-      params[i].ParameterValuePtr = number;
-      params[i].StrLen_or_IndPtr = 0;
-      
-      DEBUG_PRINTF("ODBC::GetParametersFromArray - IsInt32(): params[%i] c_type=%i type=%i buffer_length=%i size=%i length=%i value=%lld\n",
-                    i, params[i].ValueType, params[i].ParameterType,
-                    params[i].BufferLength, params[i].ColumnSize, params[i].StrLen_or_IndPtr,
-                    *number);
-    }
-    else if (value->IsNumber()) {
-      double *number   = new double(value->NumberValue());
-      
-      params[i].ValueType         = SQL_C_DOUBLE;
-      params[i].ParameterType     = SQL_DECIMAL;
-      params[i].ParameterValuePtr = number;
-      params[i].BufferLength      = sizeof(double);
-      params[i].StrLen_or_IndPtr  = params[i].BufferLength;
-      params[i].DecimalDigits     = 7;
-      params[i].ColumnSize        = sizeof(double);
-
-      DEBUG_PRINTF("ODBC::GetParametersFromArray - IsNumber(): params[%i] c_type=%i type=%i buffer_length=%i size=%i length=%i value=%f\n",
-                    i, params[i].ValueType, params[i].ParameterType,
-                    params[i].BufferLength, params[i].ColumnSize, params[i].StrLen_or_IndPtr,
-		                *number);
-    }
-    else if (value->IsBoolean()) {
-      bool *boolean = new bool(value->BooleanValue());
-      params[i].ValueType         = SQL_C_BIT;
-      params[i].ParameterType     = SQL_BIT;
-      params[i].ParameterValuePtr = boolean;
-      params[i].StrLen_or_IndPtr  = 0;
-      
-      DEBUG_PRINTF("ODBC::GetParametersFromArray - IsBoolean(): params[%i] c_type=%i type=%i buffer_length=%i size=%i length=%i\n",
-                   i, params[i].ValueType, params[i].ParameterType,
-                   params[i].BufferLength, params[i].ColumnSize, params[i].StrLen_or_IndPtr);
+/*
+ * BindRowBlock
+ * 
+ * Switch the statement to a block cursor which returns up to 
+ * block->rowCapacity rows per SQLFetch into the block's column arrays.
+ */
+
+SQLRETURN ODBC::BindRowBlock(SQLHSTMT hStmt, Column* columns, RowBlock* block) {
+  DEBUG_PRINTF("ODBC::BindRowBlock rowCapacity=%i\n", block->rowCapacity);
+  
+  SQLRETURN ret;
+  
+  ret = SQLSetStmtAttr(
+    hStmt,
+    SQL_ATTR_ROW_BIND_TYPE,
+    (SQLPOINTER) SQL_BIND_BY_COLUMN,
+    0);
+  
+  if (!SQL_SUCCEEDED(ret)) {
+    return ret;
+  }
+  
+  ret = SQLSetStmtAttr(
+    hStmt,
+    SQL_ATTR_ROW_ARRAY_SIZE,
+    (SQLPOINTER) size_t(block->rowCapacity),
+    0);
+  
+  if (!SQL_SUCCEEDED(ret)) {
+    return ret;
+  }
+  
+  ret = SQLSetStmtAttr(
+    hStmt,
+    SQL_ATTR_ROWS_FETCHED_PTR,
+    &block->rowCount,
+    0);
+  
+  if (!SQL_SUCCEEDED(ret)) {
+    return ret;
+  }
+  
+  for (int i = 0; i < block->colCount; i++) {
+    ret = SQLBindCol(
+      hStmt,
+      columns[i].index,
+      columns[i].cType,
+      block->values[i],
+      block->widths[i],
+      block->lengths[i]);
+    
+    if (!SQL_SUCCEEDED(ret)) {
+      return ret;
     }
-  } 
+  }
   
-  return params;
+  return ret;
+}
+
+/*
+ * UnbindRowBlock
+ * 
+ * Put the statement back to fetching a single row at a time without any
+ * bound columns.
+ */
+
+void ODBC::UnbindRowBlock(SQLHSTMT hStmt) {
+  DEBUG_PRINTF("ODBC::UnbindRowBlock\n");
+  
+  SQLFreeStmt(hStmt, SQL_UNBIND);
+  
+  SQLSetStmtAttr(hStmt, SQL_ATTR_ROW_ARRAY_SIZE, (SQLPOINTER) 1, 0);
+  SQLSetStmtAttr(hStmt, SQL_ATTR_ROWS_FETCHED_PTR, NULL, 0);
+}
+
+/*
+ * FetchRowBlock
+ * 
+ * Fill the block with up to block->rowCapacity rows. This does not touch v8
+ * so it is safe to call from the thread pool. If there is an error, 
+ * block->rowCount is the number of complete rows that were read before it.
+ */
+
+SQLRETURN ODBC::FetchRowBlock(SQLHSTMT hStmt, Column* columns, RowBlock* block) {
+  SQLRETURN ret;
+  
+  ResetRowBlock(block);
+  
+  if (block->bound) {
+    //the driver fills in the bound arrays and block->rowCount for us
+    ret = SQLFetch(hStmt);
+    
+    if (!SQL_SUCCEEDED(ret)) {
+      block->rowCount = 0;
+    }
+    
+    return ret;
+  }
+  
+  for (int row = 0; row < block->rowCapacity; row++) {
+    ret = SQLFetch(hStmt);
+    
+    if (ret == SQL_NO_DATA) {
+      return (row > 0) ? SQL_SUCCESS : SQL_NO_DATA;
+    }
+    else if (!SQL_SUCCEEDED(ret)) {
+      return ret;
+    }
+    
+    for (int i = 0; i < block->colCount; i++) {
+      ret = GetRowBlockData(hStmt, columns[i], block, row);
+      
+      if (!SQL_SUCCEEDED(ret)) {
+        return ret;
+      }
+    }
+    
+    block->rowCount = row + 1;
+  }
+  
+  return SQL_SUCCESS;
+}
+
+/*
+ * GetRowBlockData
+ * 
+ * Copy the value of one column of the current row into the block with 
+ * SQLGetData.
+ */
+
+SQLRETURN ODBC::GetRowBlockData(SQLHSTMT hStmt, Column column, 
+                                RowBlock* block, int row) {
+  SQLRETURN ret;
+  int col = column.index - 1;
+  SQLLEN* len = &block->lengths[col][row];
+  
+  if (block->widths[col] > 0) {
+    ret = SQLGetData(
+      hStmt,
+      column.index,
+      column.cType,
+      block->values[col] + (row * block->widths[col]),
+      block->widths[col],
+      len);
+    
+    DEBUG_PRINTF("ODBC::GetRowBlockData - Fixed: index=%i type=%i len=%i ret=%i\n", 
+                 column.index, column.type, *len, ret);
+    
+    if (ret == SQL_NO_DATA) {
+      *len = SQL_NULL_DATA;
+      ret = SQL_SUCCESS;
+    }
+    
+    return ret;
+  }
+  
+  return GetLongData(hStmt, column, &((char **) block->values[col])[row], len);
+}
+
+/*
+ * GetLongData
+ * 
+ * Read a character or binary value of any length into a buffer allocated
+ * with malloc. On return *len is the number of bytes read or SQL_NULL_DATA, 
+ * in which case *value is NULL. The caller owns *value.
+ */
+
+SQLRETURN ODBC::GetLongData(SQLHSTMT hStmt, Column column, 
+                            char** value, SQLLEN* len) {
+  SQLLEN capacity = (column.bindSize > 0) ? column.bindSize : MAX_FIELD_SIZE;
+  
+  *value = (char *) malloc(capacity);
+  
+  return ReadLongData(hStmt, column, value, capacity, 0, len);
+}
+
+/*
+ * ReadLongData
+ * 
+ * Call SQLGetData until the rest of a value has been read into *value, 
+ * which holds capacity bytes of which the first total have already been
+ * read. When the driver reports how much data is left the buffer is grown
+ * once to fit all of it; otherwise it is doubled until the value fits.
+ * 
+ * Takes ownership of *value: it is freed on error or when the value is null.
+ */
+
+SQLRETURN ODBC::ReadLongData(SQLHSTMT hStmt, Column column, char** value, 
+                             SQLLEN capacity, SQLLEN total, SQLLEN* len) {
+  SQLRETURN ret;
+#ifdef UNICODE
+  SQLLEN terminator = (column.cType == SQL_C_BINARY) ? 0 : sizeof(uint16_t);
+#else
+  SQLLEN terminator = (column.cType == SQL_C_BINARY) ? 0 : sizeof(char);
+#endif
+  //the size of one character, so that a partial read is never taken to 
+  //have ended half way through one
+  SQLLEN unit = (terminator > 0) ? terminator : 1;
+  SQLLEN chunk = 0;
+  char* buffer = *value;
+  
+  *len = (total > 0) ? total : SQL_NULL_DATA;
+  *value = NULL;
+  
+  do {
+    ret = SQLGetData(
+      hStmt,
+      column.index,
+      column.cType,
+      buffer + total,
+      capacity - total,
+      &chunk);
+    
+    DEBUG_PRINTF("ODBC::ReadLongData: index=%i type=%i len=%i ret=%i capacity=%i\n", 
+                 column.index, column.type, chunk, ret, capacity);
+    
+    if (ret == SQL_NO_DATA) {
+      //we have captured all of the data
+      break;
+    }
+    else if (!SQL_SUCCEEDED(ret)) {
+      free(buffer);
+      
+      return ret;
+    }
+    else if (chunk == SQL_NULL_DATA) {
+      break;
+    }
+    else if (chunk == SQL_NO_TOTAL || chunk > capacity - total - terminator) {
+      //the buffer was filled. chunk is what was left before this call, so
+      //if we know it we can make room for all of the rest at once
+      SQLLEN needed = (chunk == SQL_NO_TOTAL) 
+        ? capacity * 2 
+        : total + chunk + terminator;
+      
+      total += ((capacity - total - terminator) / unit) * unit;
+      capacity = needed;
+      buffer = (char *) realloc(buffer, capacity);
+      *len = total;
+    }
+    else {
+      total += chunk;
+      *len = total;
+      
+      //some drivers do not report SQL_NO_DATA after the last chunk, so
+      //don't go around again
+      break;
+    }
+  } while (true);
+  
+  if (*len == SQL_NULL_DATA) {
+    free(buffer);
+  }
+  else {
+    *value = buffer;
+  }
+  
+  return SQL_SUCCESS;
+}
+
+/*
+ * IsRowBlockTruncated
+ * 
+ * Check whether any character data in the fetched rows did not fit in
+ * the buffer that was bound for its column.
+ */
+
+bool ODBC::IsRowBlockTruncated(Column* columns, RowBlock* block) {
+  if (!block->bound) {
+    //values read with SQLGetData are never truncated
+    return false;
+  }
+  
+  for (int i = 0; i < block->colCount; i++) {
+    SQLLEN terminator;
+    
+    if (columns[i].cType == SQL_C_BINARY) {
+      terminator = 0;
+    }
+    else if (columns[i].cType == SQL_C_TCHAR || columns[i].cType == SQL_C_CHAR) {
+#ifdef UNICODE
+      terminator = (columns[i].cType == SQL_C_TCHAR) ? sizeof(uint16_t) : sizeof(char);
+#else
+      terminator = sizeof(char);
+#endif
+    }
+    else {
+      continue;
+    }
+    
+    for (SQLULEN row = 0; row < block->rowCount; row++) {
+      SQLLEN len = block->lengths[i][row];
+      
+      if (len == SQL_NO_TOTAL || len > block->widths[i] - terminator) {
+        return true;
+      }
+    }
+  }
+  
+  return false;
+}
+
+/*
+ * GetBlockColumnValue
+ */
+
+Handle<Value> ODBC::GetBlockColumnValue( Column column, RowBlock* block, int row) {
+  NanEscapableScope();
+  
+  int col = column.index - 1;
+  SQLLEN len = block->lengths[col][row];
+  char* value;
+  
+  if (len == SQL_NULL_DATA) {
+    return NanEscapeScope(NanNull());
+  }
+  
+  if (block->widths[col] > 0) {
+    value = block->values[col] + (row * block->widths[col]);
+  }
+  else {
+    value = ((char **) block->values[col])[row];
+    
+    if (column.cType == SQL_C_BINARY) {
+      //this value has an allocation of its own, so hand it to the Buffer
+      //instead of copying it
+      ((char **) block->values[col])[row] = NULL;
+      
+      return NanEscapeScope(NanNewBufferHandle(value, len, FreeBufferData, NULL));
+    }
+  }
+  
+  return NanEscapeScope(column.decode(value, len));
+}
+
+/*
+ * GetBlockRecordTuple
+ */
+
+Local<Object> ODBC::GetBlockRecordTuple ( Column* columns, short* colCount,
+                                          RowBlock* block, int row,
+                                          Local<Object> recordTemplate) {
+  NanEscapableScope();
+  
+  Local<Object> tuple = recordTemplate->Clone();
+        
+  for(int i = 0; i < *colCount; i++) {
+    tuple->Set( NanNew(*columns[i].key),
+                GetBlockColumnValue( columns[i], block, row));
+  }
+  
+  return NanEscapeScope(tuple);
+}
+
+/*
+ * GetBlockRecordArray
+ */
+
+Handle<Value> ODBC::GetBlockRecordArray ( Column* columns, short* colCount,
+                                          RowBlock* block, int row) {
+  NanEscapableScope();
+  
+  Local<Array> array = NanNew<Array>();
+        
+  for(int i = 0; i < *colCount; i++) {
+    array->Set( NanNew(i),
+                GetBlockColumnValue( columns[i], block, row));
+  }
+  
+  return NanEscapeScope(array);
+}
+
+/*
+ * AllocColumnVectors
+ */
+
+ColumnVector* ODBC::AllocColumnVectors(short colCount) {
+  return (ColumnVector *) calloc(colCount, sizeof(ColumnVector));
+}
+
+/*
+ * FreeColumnVectors
+ */
+
+void ODBC::FreeColumnVectors(ColumnVector* vectors, short colCount) {
+  if (vectors == NULL) {
+    return;
+  }
+  
+  for (int i = 0; i < colCount; i++) {
+    free(vectors[i].values);
+    free(vectors[i].nulls);
+  }
+  
+  free(vectors);
+}
+
+/*
+ * AppendColumnVectors
+ * 
+ * Add the rows in the block to the per column vectors. Integer and double
+ * values are copied as they are; everything else is converted to a
+ * javascript value and stored in arrays[column].
+ */
+
+void ODBC::AppendColumnVectors(Column* columns, short* colCount, RowBlock* block,
+                               ColumnVector* vectors, Local<Array> arrays) {
+  NanScope();
+  
+  for (int i = 0; i < *colCount; i++) {
+    ColumnVector* vector = &vectors[i];
+    bool numeric = (columns[i].cType == SQL_C_SLONG || columns[i].cType == SQL_C_DOUBLE);
+    SQLLEN width = block->widths[i];
+    
+    if (vector->count + block->rowCount > vector->capacity) {
+      vector->capacity = (vector->capacity > 0) ? vector->capacity * 2 : block->rowCapacity;
+      
+      while (vector->capacity < vector->count + block->rowCount) {
+        vector->capacity *= 2;
+      }
+      
+      vector->nulls = (unsigned char *) realloc(vector->nulls, vector->capacity);
+      
+      if (numeric) {
+        vector->values = (char *) realloc(vector->values, vector->capacity * width);
+      }
+    }
+    
+    Local<Array> values;
+    
+    if (!numeric) {
+      if (!arrays->Has(i)) {
+        arrays->Set(i, NanNew<Array>());
+      }
+      
+      values = Local<Array>::Cast(arrays->Get(i));
+    }
+    
+    for (SQLULEN row = 0; row < block->rowCount; row++) {
+      bool isNull = (block->lengths[i][row] == SQL_NULL_DATA);
+      
+      vector->nulls[vector->count] = isNull ? 1 : 0;
+      
+      if (numeric) {
+        if (isNull) {
+          memset(vector->values + (vector->count * width), 0, width);
+        }
+        else {
+          memcpy(vector->values + (vector->count * width), 
+                 block->values[i] + (row * width), 
+                 width);
+        }
+      }
+      else {
+        values->Set(vector->count, GetBlockColumnValue(columns[i], block, row));
+      }
+      
+      vector->count++;
+    }
+  }
+}
+
+/*
+ * GetColumnVectors
+ * 
+ * Build { columns : { name : values }, nulls : { name : Uint8Array } } from
+ * the collected vectors. Integer and double columns are returned as 
+ * Int32Array and Float64Array where the version of v8 supports it.
+ */
+
+Local<Object> ODBC::GetColumnVectors(Column* columns, short* colCount,
+                                     ColumnVector* vectors, Local<Array> arrays) {
+  NanEscapableScope();
+  
+  Local<Object> result = NanNew<Object>();
+  Local<Object> objColumns = NanNew<Object>();
+  Local<Object> objNulls = NanNew<Object>();
+  
+  for (int i = 0; i < *colCount; i++) {
+    ColumnVector* vector = &vectors[i];
+    size_t count = vector->count;
+    Local<Value> values;
+    Local<Value> nulls;
+    Local<String> name = NanNew(*columns[i].key);
+    
+#if (NODE_MODULE_VERSION < NODE_0_12_MODULE_VERSION)
+    Local<Array> arrNulls = NanNew<Array>(count);
+    
+    for (size_t row = 0; row < count; row++) {
+      arrNulls->Set(row, NanNew<Integer>(vector->nulls[row]));
+    }
+    
+    nulls = arrNulls;
+    
+    if (columns[i].cType == SQL_C_SLONG || columns[i].cType == SQL_C_DOUBLE) {
+      Local<Array> arrValues = NanNew<Array>(count);
+      
+      for (size_t row = 0; row < count; row++) {
+        if (columns[i].cType == SQL_C_SLONG) {
+          arrValues->Set(row, NanNew<Integer>(((int32_t *) vector->values)[row]));
+        }
+        else {
+          arrValues->Set(row, NanNew<Number>(((double *) vector->values)[row]));
+        }
+      }
+      
+      values = arrValues;
+    }
+#else
+    Local<ArrayBuffer> nullBuffer = ArrayBuffer::New(Isolate::GetCurrent(), count);
+    
+    if (count > 0) {
+      memcpy(nullBuffer->GetContents().Data(), vector->nulls, count);
+    }
+    
+    nulls = Uint8Array::New(nullBuffer, 0, count);
+    
+    if (columns[i].cType == SQL_C_SLONG || columns[i].cType == SQL_C_DOUBLE) {
+      size_t width = (columns[i].cType == SQL_C_SLONG) ? sizeof(int32_t) : sizeof(double);
+      Local<ArrayBuffer> valueBuffer = ArrayBuffer::New(Isolate::GetCurrent(), count * width);
+      
+      if (count > 0) {
+        memcpy(valueBuffer->GetContents().Data(), vector->values, count * width);
+      }
+      
+      if (columns[i].cType == SQL_C_SLONG) {
+        values = Int32Array::New(valueBuffer, 0, count);
+      }
+      else {
+        values = Float64Array::New(valueBuffer, 0, count);
+      }
+    }
+#endif
+    else if (arrays->Has(i)) {
+      values = arrays->Get(i);
+    }
+    else {
+      values = NanNew<Array>();
+    }
+    
+    objColumns->Set(name, values);
+    objNulls->Set(name, nulls);
+  }
+  
+  result->Set(NanNew("columns"), objColumns);
+  result->Set(NanNew("nulls"), objNulls);
+  
+  return NanEscapeScope(result);
+}
+
+/*
+ * IsParameterDescriptor
+ * 
+ * A parameter may be given as { value, type, size, scale } to bind it as
+ * exactly that SQL type instead of one guessed from the value.
+ */
+
+bool ODBC::IsParameterDescriptor (Local<Value> value) {
+  return value->IsObject() && !value->IsArray() && !value->IsDate()
+    && !Buffer::HasInstance(value)
+    && value->ToObject()->Has(NanNew(OPTION_TYPE));
+}
+
+/*
+ * DescribeParameter
+ * 
+ * Decide the C type, SQL type, column size and decimal digits a value is
+ * bound with, and return the value itself, which is the descriptor's value
+ * when it is given a descriptor. StrLen_or_IndPtr is only set, to one of
+ * the data-at-execution lengths, for a streamed parameter.
+ */
+
+Local<Value> ODBC::DescribeParameter (Local<Value> value, Parameter* param, ParameterDescription* description) {
+  param->ColumnSize    = 0;
+  param->DecimalDigits = 0;
+  
+  if (IsParameterDescriptor(value)) {
+    Local<Object> descriptor = value->ToObject();
+    Local<Value> size = descriptor->Get(NanNew(OPTION_SIZE));
+    Local<Value> scale = descriptor->Get(NanNew(OPTION_SCALE));
+    
+    value = descriptor->Get(NanNew(OPTION_VALUE));
+    
+    param->ParameterType = descriptor->Get(NanNew(OPTION_TYPE))->Int32Value();
+    
+    if (Buffer::HasInstance(value)) {
+      param->ValueType = SQL_C_BINARY;
+    }
+    else if (value->IsDate()) {
+      param->ValueType = SQL_C_TYPE_TIMESTAMP;
+    }
+    else switch (param->ParameterType) {
+      case SQL_BIT :
+        param->ValueType = (value->IsBoolean() || value->IsNumber())
+          ? SQL_C_BIT
+          : SQL_C_TCHAR;
+        break;
+      case SQL_TINYINT :
+      case SQL_SMALLINT :
+      case SQL_INTEGER :
+      case SQL_BIGINT :
+        param->ValueType = (value->IsNumber())
+          ? SQL_C_SBIGINT
+          : SQL_C_TCHAR;
+        break;
+      case SQL_REAL :
+      case SQL_FLOAT :
+      case SQL_DOUBLE :
+      case SQL_DECIMAL :
+      case SQL_NUMERIC :
+        //a string is passed through as is so that decimals too precise
+        //for a double stay exact
+        param->ValueType = (value->IsNumber())
+          ? SQL_C_DOUBLE
+          : SQL_C_TCHAR;
+        break;
+      default :
+        //let the driver convert the string to anything else
+        param->ValueType = SQL_C_TCHAR;
+    }
+    
+    if (value->IsNull() || value->IsUndefined()) {
+      param->ValueType = SQL_C_DEFAULT;
+    }
+    
+    if (size->IsNumber()) {
+      param->ColumnSize = size->Int32Value();
+    }
+    else if (param->ParameterType == SQL_DECIMAL 
+        || param->ParameterType == SQL_NUMERIC) {
+      param->ColumnSize = 38;
+    }
+    else if (param->ValueType == SQL_C_TCHAR) {
+      int length = value->ToString()->Length();
+      
+      param->ColumnSize = (length > 0) ? length : 1;
+    }
+    else if (param->ValueType == SQL_C_BINARY) {
+      size_t length = Buffer::Length(value->ToObject());
+      
+      param->ColumnSize = (length > 0) ? length : 1;
+    }
+    else if (param->ValueType == SQL_C_TYPE_TIMESTAMP) {
+      param->ColumnSize = 23;
+      param->DecimalDigits = 3;
+    }
+    
+    if (scale->IsNumber()) {
+      param->DecimalDigits = scale->Int32Value();
+    }
+    
+    //the value is sent in pieces with putData once the statement has been
+    //executed, optionally telling the driver up front how long it will be
+    if (descriptor->Get(NanNew(OPTION_STREAM))->IsTrue()) {
+      Local<Value> length = descriptor->Get(NanNew(OPTION_LENGTH));
+      
+      param->ValueType = SQL_C_BINARY;
+      param->StrLen_or_IndPtr = (length->IsNumber())
+        ? SQL_LEN_DATA_AT_EXEC(length->IntegerValue())
+        : SQL_DATA_AT_EXEC;
+    }
+    
+    return value;
+  }
+  
+  if (value->IsString()) {
+    param->ValueType     = SQL_C_TCHAR;
+    param->ColumnSize    = 0; //SQL_SS_LENGTH_UNLIMITED 
+#ifdef UNICODE
+    param->ParameterType = SQL_WVARCHAR;
+#else
+    param->ParameterType = SQL_VARCHAR;
+#endif
+  }
+  else if (value->IsInt32()) {
+    param->ValueType     = SQL_C_SBIGINT;
+    param->ParameterType = SQL_BIGINT;
+  }
+  else if (value->IsNumber()) {
+    param->ValueType     = SQL_C_DOUBLE;
+    param->ParameterType = SQL_DECIMAL;
+    param->DecimalDigits = 7;
+    param->ColumnSize    = sizeof(double);
+  }
+  else if (value->IsBoolean()) {
+    param->ValueType     = SQL_C_BIT;
+    param->ParameterType = SQL_BIT;
+  }
+  else if (value->IsDate()) {
+    param->ValueType     = SQL_C_TYPE_TIMESTAMP;
+    param->ParameterType = SQL_TYPE_TIMESTAMP;
+    param->ColumnSize    = 23;
+    param->DecimalDigits = 3;
+  }
+  else if (Buffer::HasInstance(value)) {
+    size_t length = Buffer::Length(value->ToObject());
+    
+    param->ValueType     = SQL_C_BINARY;
+    param->ParameterType = SQL_VARBINARY;
+    param->ColumnSize    = (length > 0) ? length : 1;
+  }
+  else {
+    //null and anything we do not know how to send
+    param->ValueType     = SQL_C_DEFAULT;
+    param->ParameterType = SQL_VARCHAR;
+  }
+  
+  if (description) {
+    ApplyParameterDescription(value, param, description);
+  }
+  
+  return value;
+}
+
+/*
+ * ApplyParameterDescription
+ * 
+ * Bind a value as the type the driver described for the parameter, so the
+ * server does not have to convert it, when the value is of the same kind
+ * as that type. A value of another kind keeps the type guessed for it.
+ */
+
+void ODBC::ApplyParameterDescription (Local<Value> value, Parameter* param, ParameterDescription* description) {
+  SQLSMALLINT valueType;
+  SQLULEN size = description->ParameterSize;
+  
+  switch (description->DataType) {
+    case SQL_CHAR :
+    case SQL_VARCHAR :
+    case SQL_LONGVARCHAR :
+    case SQL_WCHAR :
+    case SQL_WVARCHAR :
+    case SQL_WLONGVARCHAR :
+      if (!value->IsString()) {
+        valueType = SQL_C_DEFAULT;
+        break;
+      }
+      
+      valueType = SQL_C_TCHAR;
+      
+      //a driver that can not really describe parameters may give a size 
+      //that is too small; let the server be the one to complain
+      if ((SQLULEN) value->ToString()->Length() > size) {
+        size = value->ToString()->Length();
+      }
+      break;
+    case SQL_BIT :
+      valueType = (value->IsBoolean()) ? SQL_C_BIT : SQL_C_DEFAULT;
+      break;
+    case SQL_TINYINT :
+    case SQL_SMALLINT :
+    case SQL_INTEGER :
+    case SQL_BIGINT :
+      valueType = (value->IsInt32()) 
+        ? SQL_C_SBIGINT 
+        : (value->IsNumber()) ? SQL_C_DOUBLE : SQL_C_DEFAULT;
+      break;
+    case SQL_REAL :
+    case SQL_FLOAT :
+    case SQL_DOUBLE :
+    case SQL_DECIMAL :
+    case SQL_NUMERIC :
+      valueType = (value->IsNumber()) ? SQL_C_DOUBLE : SQL_C_DEFAULT;
+      break;
+    case SQL_TYPE_TIMESTAMP :
+      valueType = (value->IsDate()) ? SQL_C_TYPE_TIMESTAMP : SQL_C_DEFAULT;
+      break;
+    default :
+      valueType = SQL_C_DEFAULT;
+  }
+  
+  //null is bound as whatever the parameter is
+  if (value->IsNull() || value->IsUndefined()) {
+    valueType = SQL_C_DEFAULT;
+  }
+  else if (valueType == SQL_C_DEFAULT) {
+    return;
+  }
+  
+  param->ValueType     = valueType;
+  param->ParameterType = description->DataType;
+  param->ColumnSize    = size;
+  param->DecimalDigits = description->DecimalDigits;
+}
+
+/*
+ * DescribeParameters
+ * 
+ * Ask the driver for the type of each of a prepared statement's parameters.
+ * Returns NULL, with count set to 0, if the statement has no parameters or
+ * the driver can not describe them. Release the result with free.
+ */
+
+ParameterDescription* ODBC::DescribeParameters (SQLHSTMT hStmt, SQLSMALLINT* count) {
+  SQLSMALLINT nullable;
+  SQLRETURN ret = SQLNumParams(hStmt, count);
+  
+  if (!SQL_SUCCEEDED(ret) || *count <= 0) {
+    *count = 0;
+    
+    return NULL;
+  }
+  
+  ParameterDescription* descriptions = 
+    (ParameterDescription *) malloc(*count * sizeof(ParameterDescription));
+  
+  for (int i = 0; i < *count; i++) {
+    ret = SQLDescribeParam(
+      hStmt,
+      i + 1,
+      &descriptions[i].DataType,
+      &descriptions[i].ParameterSize,
+      &descriptions[i].DecimalDigits,
+      &nullable);
+    
+    if (!SQL_SUCCEEDED(ret)) {
+      free(descriptions);
+      *count = 0;
+      
+      return NULL;
+    }
+    
+    DEBUG_PRINTF("ODBC::DescribeParameters - param[%i] type=%i size=%i digits=%i\n",
+                 i, descriptions[i].DataType, descriptions[i].ParameterSize,
+                 descriptions[i].DecimalDigits);
+  }
+  
+  return descriptions;
+}
+
+/*
+ * GetParametersFromArray
+ * 
+ * The Parameter array and every value it points to are put in one 
+ * allocation, sized by a first pass over the values, so that the whole
+ * thing can be released with FreeParameters.
+ */
+
+Parameter* ODBC::GetParametersFromArray (Local<Array> values, int *paramCount) {
+  return GetParametersFromArray(values, paramCount, NULL);
+}
+
+/*
+ * GetParametersFromArray
+ * 
+ * As above, binding each value as the type the driver described for its
+ * parameter where it can. descriptions must have an entry for every value.
+ */
+
+Parameter* ODBC::GetParametersFromArray (Local<Array> values, int *paramCount, ParameterDescription* descriptions) {
+  DEBUG_PRINTF("ODBC::GetParametersFromArray\n");
+  *paramCount = values->Length();
+  
+  if (*paramCount == 0) {
+    return NULL;
+  }
+  
+  //size the arena: the Parameter array followed by each value, every one
+  //of them aligned for a double
+  size_t size = ALIGN_PARAMETER(*paramCount * sizeof(Parameter));
+  
+  for (int i = 0; i < *paramCount; i++) {
+    Parameter plan;
+    plan.StrLen_or_IndPtr = SQL_NULL_DATA;
+    
+    Local<Value> value = DescribeParameter(
+      values->Get(i), 
+      &plan, 
+      (descriptions) ? &descriptions[i] : NULL);
+    
+    if (plan.StrLen_or_IndPtr != SQL_NULL_DATA) {
+      //streamed, nothing to store
+      continue;
+    }
+    
+    switch (plan.ValueType) {
+      case SQL_C_TCHAR :
+#ifdef UNICODE
+        size += ALIGN_PARAMETER(GetParameterBufferLength(
+          (value->ToString()->Length() * sizeof(uint16_t)) + sizeof(uint16_t)));
+#else
+        size += ALIGN_PARAMETER(GetParameterBufferLength(
+          value->ToString()->Utf8Length() + 1));
+#endif
+        break;
+      case SQL_C_SBIGINT :
+        size += ALIGN_PARAMETER(sizeof(int64_t));
+        break;
+      case SQL_C_DOUBLE :
+        size += ALIGN_PARAMETER(sizeof(double));
+        break;
+      case SQL_C_BIT :
+        size += ALIGN_PARAMETER(sizeof(bool));
+        break;
+      case SQL_C_TYPE_TIMESTAMP :
+        size += ALIGN_PARAMETER(sizeof(SQL_TIMESTAMP_STRUCT));
+        break;
+      //a Buffer is bound where it is
+    }
+  }
+  
+  Parameter* params = (Parameter *) malloc(size);
+  char* next = (char *) params + ALIGN_PARAMETER(*paramCount * sizeof(Parameter));
+  
+  for (int i = 0; i < *paramCount; i++) {
+    params[i].StrLen_or_IndPtr  = SQL_NULL_DATA;
+    params[i].BufferLength      = 0;
+    params[i].ParameterValuePtr = NULL;
+    params[i].buffer            = NULL;
+    params[i].grown             = NULL;
+    params[i].rebind            = false;
+    
+    Local<Value> value = DescribeParameter(
+      values->Get(i), 
+      &params[i], 
+      (descriptions) ? &descriptions[i] : NULL);
+
+    DEBUG_PRINTF("ODBC::GetParametersFromArray - &param[%i].length = %X\n",
+                 i, &params[i].StrLen_or_IndPtr);
+
+    if (params[i].StrLen_or_IndPtr != SQL_NULL_DATA) {
+      //SQLParamData gives this back to say which parameter it wants next
+      params[i].ParameterValuePtr = &params[i];
+    }
+    else if (params[i].ValueType == SQL_C_TCHAR) {
+      Local<String> string = value->ToString();
+      
+      //leave room for the longer strings a prepared statement is likely to
+      //be given next
+#ifdef UNICODE
+      params[i].BufferLength      = GetParameterBufferLength(
+        (string->Length() * sizeof(uint16_t)) + sizeof(uint16_t));
+#else
+      params[i].BufferLength      = GetParameterBufferLength(
+        string->Utf8Length() + 1);
+#endif
+      params[i].ParameterValuePtr = next;
+      params[i].StrLen_or_IndPtr  = SQL_NTS;//params[i].BufferLength;
+
+#ifdef UNICODE
+      string->Write((uint16_t *) params[i].ParameterValuePtr);
+#else
+      string->WriteUtf8((char *) params[i].ParameterValuePtr);
+#endif
+      
+      next += ALIGN_PARAMETER(params[i].BufferLength);
+    }
+    else if (params[i].ValueType == SQL_C_SBIGINT) {
+      int64_t  *number = (int64_t *) next;
+      *number = value->IntegerValue();
+      next += ALIGN_PARAMETER(sizeof(int64_t));
+      
+      params[i].ParameterValuePtr = number;
+      params[i].StrLen_or_IndPtr = 0;
+    }
+    else if (params[i].ValueType == SQL_C_DOUBLE) {
+      double *number = (double *) next;
+      *number = value->NumberValue();
+      next += ALIGN_PARAMETER(sizeof(double));
+      
+      params[i].ParameterValuePtr = number;
+      params[i].BufferLength      = sizeof(double);
+      params[i].StrLen_or_IndPtr  = params[i].BufferLength;
+    }
+    else if (params[i].ValueType == SQL_C_BIT) {
+      bool *boolean = (bool *) next;
+      *boolean = value->BooleanValue();
+      next += ALIGN_PARAMETER(sizeof(bool));
+      
+      params[i].ParameterValuePtr = boolean;
+      params[i].StrLen_or_IndPtr  = 0;
+    }
+    else if (params[i].ValueType == SQL_C_TYPE_TIMESTAMP) {
+      SQL_TIMESTAMP_STRUCT *timestamp = (SQL_TIMESTAMP_STRUCT *) next;
+      EncodeTimestamp(value, timestamp);
+      next += ALIGN_PARAMETER(sizeof(SQL_TIMESTAMP_STRUCT));
+      
+      params[i].ParameterValuePtr = timestamp;
+      params[i].BufferLength      = sizeof(SQL_TIMESTAMP_STRUCT);
+      params[i].StrLen_or_IndPtr  = params[i].BufferLength;
+    }
+    else if (params[i].ValueType == SQL_C_BINARY) {
+      Local<Object> buffer = value->ToObject();
+      
+      //bind the Buffer's own memory and hold on to the Buffer so that it
+      //is still there when the statement is executed on the thread pool
+      params[i].buffer = new Persistent<Object>();
+      NanAssignPersistent(*params[i].buffer, buffer);
+      
+      params[i].ParameterValuePtr = Buffer::Data(buffer);
+      params[i].BufferLength      = Buffer::Length(buffer);
+      params[i].StrLen_or_IndPtr  = params[i].BufferLength;
+    }
+    
+    DEBUG_PRINTF("ODBC::GetParametersFromArray - params[%i] c_type=%i type=%i buffer_length=%i size=%i digits=%i length=%i\n",
+                 i, params[i].ValueType, params[i].ParameterType,
+                 params[i].BufferLength, params[i].ColumnSize, 
+                 params[i].DecimalDigits, params[i].StrLen_or_IndPtr);
+  } 
+  
+  return params;
+}
+
+/*
+ * UpdateParameters
+ * 
+ * Write new values into parameters made by GetParametersFromArray so that
+ * they do not have to be bound again. A string too long for its buffer is
+ * given a bigger one and the parameter is marked with rebind, so that only
+ * it is bound again. Returns false, having possibly written some of the 
+ * values, if there is a value that can not be written in place, such as one
+ * of another type; make new parameters in that case.
+ */
+
+bool ODBC::UpdateParameters (Parameter* params, int paramCount, Local<Array> values) {
+  if ((int) values->Length() != paramCount) {
+    return false;
+  }
+  
+  for (int i = 0; i < paramCount; i++) {
+    Local<Value> value = values->Get(i);
+    Parameter* prm = &params[i];
+    
+    if (IsParameterDescriptor(value)) {
+      Parameter plan;
+      plan.StrLen_or_IndPtr = SQL_NULL_DATA;
+      
+      value = DescribeParameter(value, &plan, NULL);
+      
+      //the statement keeps the plan it was bound with; a descriptor asking
+      //for a different one needs a new binding
+      if (plan.ParameterType != prm->ParameterType
+          || plan.ColumnSize > prm->ColumnSize
+          || plan.DecimalDigits != prm->DecimalDigits) {
+        return false;
+      }
+      
+      if (plan.StrLen_or_IndPtr != SQL_NULL_DATA) {
+        if (prm->ParameterValuePtr != prm) {
+          return false;
+        }
+        
+        prm->StrLen_or_IndPtr = plan.StrLen_or_IndPtr;
+        
+        continue;
+      }
+    }
+    
+    if (value->IsNull()) {
+      prm->StrLen_or_IndPtr = SQL_NULL_DATA;
+    }
+    else if (prm->ParameterValuePtr == NULL) {
+      //bound as null, there is no buffer to write to
+      return false;
+    }
+    else if (value->IsString() && prm->ValueType == SQL_C_TCHAR) {
+      Local<String> string = value->ToString();
+#ifdef UNICODE
+      SQLLEN length = (string->Length() * sizeof(uint16_t)) + sizeof(uint16_t);
+#else
+      SQLLEN length = string->Utf8Length() + 1;
+#endif
+      
+      if (length > prm->BufferLength) {
+        free(prm->grown);
+        
+        prm->BufferLength = GetParameterBufferLength(length);
+        prm->grown = (char *) malloc(prm->BufferLength);
+        prm->ParameterValuePtr = prm->grown;
+        prm->rebind = true;
+      }
+      
+      //a parameter typed by the driver was bound with a size big enough for
+      //the string it was first given (see ApplyParameterDescription); a 
+      //longer one needs the size raised or the driver would truncate it
+      if (prm->ColumnSize != 0 && string->Length() > prm->ColumnSize) {
+        prm->ColumnSize = string->Length();
+        prm->rebind = true;
+      }
+      
+#ifdef UNICODE
+      string->Write((uint16_t *) prm->ParameterValuePtr);
+#else
+      string->WriteUtf8((char *) prm->ParameterValuePtr);
+#endif
+      prm->StrLen_or_IndPtr = SQL_NTS;
+    }
+    else if (value->IsInt32() && prm->ValueType == SQL_C_SBIGINT) {
+      *(int64_t *) prm->ParameterValuePtr = value->IntegerValue();
+      prm->StrLen_or_IndPtr = 0;
+    }
+    else if (value->IsNumber() && prm->ValueType == SQL_C_DOUBLE) {
+      *(double *) prm->ParameterValuePtr = value->NumberValue();
+      prm->StrLen_or_IndPtr = sizeof(double);
+    }
+    else if (value->IsBoolean() && prm->ValueType == SQL_C_BIT) {
+      *(bool *) prm->ParameterValuePtr = value->BooleanValue();
+      prm->StrLen_or_IndPtr = 0;
+    }
+    else if (value->IsDate() && prm->ValueType == SQL_C_TYPE_TIMESTAMP) {
+      EncodeTimestamp(value, (SQL_TIMESTAMP_STRUCT *) prm->ParameterValuePtr);
+      prm->StrLen_or_IndPtr = sizeof(SQL_TIMESTAMP_STRUCT);
+    }
+    else if (Buffer::HasInstance(value) && prm->ValueType == SQL_C_BINARY
+        && Buffer::Data(value->ToObject()) == prm->ParameterValuePtr
+        && (SQLLEN) Buffer::Length(value->ToObject()) <= prm->ColumnSize) {
+      //only the same Buffer can be sent again without binding it again
+      prm->StrLen_or_IndPtr = Buffer::Length(value->ToObject());
+    }
+    else {
+      return false;
+    }
+  }
+  
+  return true;
+}
+
+/*
+ * GetParameterBufferLength
+ * 
+ * The size of buffer to give a string parameter of length bytes: the next 
+ * power of two, so that a statement executed with strings of slowly growing
+ * length only needs a few bigger buffers.
+ */
+
+SQLLEN ODBC::GetParameterBufferLength (SQLLEN length) {
+  SQLLEN size = 16;
+  
+  while (size < length) {
+    size <<= 1;
+  }
+  
+  return size;
+}
+
+/*
+ * FreeParameters
+ * 
+ * Release parameters made by GetParametersFromArray.
+ */
+
+void ODBC::FreeParameters (Parameter* params, int paramCount) {
+  DEBUG_PRINTF("ODBC::FreeParameters paramCount=%i\n", paramCount);
+  
+  for (int i = 0; i < paramCount; i++) {
+    if (params[i].buffer != NULL) {
+      NanDisposePersistent(*params[i].buffer);
+      delete params[i].buffer;
+    }
+    
+    free(params[i].grown);
+  }
+  
+  free(params);
+}
+
+/*
+ * CreateDriverLock
+ * 
+ * Make the lock for a new connection, with one reference held by it.
+ */
+
+DriverLock* ODBC::CreateDriverLock (int mode) {
+  DriverLock* lock = (DriverLock *) calloc(1, sizeof(DriverLock));
+  
+  lock->mode = mode;
+  lock->refs = 1;
+  
+  uv_mutex_init(&lock->mutex);
+  
+  return lock;
+}
+
+void ODBC::RetainDriverLock (DriverLock* lock) {
+  if (lock) {
+    lock->refs++;
+  }
+}
+
+void ODBC::ReleaseDriverLock (DriverLock* lock) {
+  if (lock && --lock->refs == 0) {
+    if (lock->worker) {
+      ODBCWorkerPool::DestroyQueue(lock->worker);
+    }
+    
+    uv_mutex_destroy(&lock->mutex);
+    free(lock);
+  }
+}
+
+/*
+ * LockDriver
+ * 
+ * Take the mutex a lock's mode calls for, counting whether we had to wait 
+ * for it, and return it to be given to UnlockDriver. A NULL lock takes the
+ * global mutex; LOCK_NONE takes nothing and returns NULL.
+ */
+
+uv_mutex_t* ODBC::LockDriver (DriverLock* lock) {
+  uv_mutex_t* mutex = &ODBC::g_odbcMutex;
+  
+  if (lock && lock->mode == LOCK_NONE) {
+    return NULL;
+  }
+  else if (lock && lock->mode == LOCK_CONNECTION) {
+    mutex = &lock->mutex;
+  }
+  
+  bool contended = (uv_mutex_trylock(mutex) != 0);
+  
+  if (contended) {
+    uv_mutex_lock(mutex);
+  }
+  
+  if (lock) {
+    lock->acquisitions++;
+    
+    if (contended) {
+      lock->contentions++;
+    }
+  }
+  
+  return mutex;
+}
+
+/*
+ * TryLockDriver
+ * 
+ * LockDriver for the main thread, which must not wait: returns false, 
+ * having taken nothing, if someone else holds the mutex. Otherwise sets 
+ * mutex to what is to be given to UnlockDriver.
+ */
+
+bool ODBC::TryLockDriver (DriverLock* lock, uv_mutex_t** mutex) {
+  *mutex = NULL;
+  
+  if (lock && lock->mode == LOCK_NONE) {
+    return true;
+  }
+  
+  uv_mutex_t* held = (lock && lock->mode == LOCK_CONNECTION) 
+    ? &lock->mutex 
+    : &ODBC::g_odbcMutex;
+  
+  if (uv_mutex_trylock(held) != 0) {
+    return false;
+  }
+  
+  if (lock) {
+    lock->acquisitions++;
+  }
+  
+  *mutex = held;
+  
+  return true;
+}
+
+void ODBC::UnlockDriver (uv_mutex_t* mutex) {
+  if (mutex) {
+    uv_mutex_unlock(mutex);
+  }
+}
+
+/*
+ * EnableAsync
+ * 
+ * Turn on asynchronous execution for a statement, if the driver can do it.
+ */
+
+bool ODBC::EnableAsync (SQLHSTMT hStmt) {
+  SQLRETURN ret = SQLSetStmtAttr(
+    hStmt,
+    SQL_ATTR_ASYNC_ENABLE,
+    (SQLPOINTER) SQL_ASYNC_ENABLE_ON,
+    0);
+  
+  DEBUG_PRINTF("ODBC::EnableAsync ret=%i\n", ret);
+  
+  return SQL_SUCCEEDED(ret);
+}
+
+/*
+ * PollAsync
+ * 
+ * Make a call on the main thread to a statement that has had EnableAsync
+ * turned on, then keep making it from a timer, backing off to 
+ * MAX_ASYNC_POLL_INTERVAL, until the driver has finished. Asynchronous 
+ * execution is then turned off again, so that the rest of the work can be
+ * done on the thread pool as usual, and after is called as though call had
+ * run there. No thread is tied up while the database does the work.
+ */
+
+void ODBC::PollAsync (uv_work_t* req, SQLHSTMT hStmt, AsyncPollCall call, uv_after_work_cb after) {
+  async_poll_data* poll = (async_poll_data *) calloc(1, sizeof(async_poll_data));
+  
+  poll->req = req;
+  poll->hStmt = hStmt;
+  poll->call = call;
+  poll->after = after;
+  poll->interval = ASYNC_POLL_INTERVAL;
+  poll->result = call(req);
+  
+  uv_timer_init(uv_default_loop(), &poll->timer);
+  poll->timer.data = poll;
+  
+  //always call back from the timer, even if the driver finished straight away
+  uv_timer_start(
+    &poll->timer,
+    UV_PollAsync,
+    (poll->result == SQL_STILL_EXECUTING) ? poll->interval : 0,
+    0);
+}
+
+#if UV_VERSION_MAJOR >= 1
+void ODBC::UV_PollAsync (uv_timer_t* timer) {
+#else
+void ODBC::UV_PollAsync (uv_timer_t* timer, int status) {
+#endif
+  async_poll_data* poll = (async_poll_data *) timer->data;
+  
+  if (poll->result == SQL_STILL_EXECUTING) {
+    poll->result = poll->call(poll->req);
+  }
+  
+  if (poll->result == SQL_STILL_EXECUTING) {
+    if (poll->interval < MAX_ASYNC_POLL_INTERVAL) {
+      poll->interval *= 2;
+    }
+    
+    uv_timer_start(&poll->timer, UV_PollAsync, poll->interval, 0);
+    
+    return;
+  }
+  
+  DEBUG_PRINTF("ODBC::UV_PollAsync result=%i\n", poll->result);
+  
+  SQLSetStmtAttr(
+    poll->hStmt,
+    SQL_ATTR_ASYNC_ENABLE,
+    (SQLPOINTER) SQL_ASYNC_ENABLE_OFF,
+    0);
+  
+  poll->after(poll->req, 0);
+  
+  uv_close((uv_handle_t *) &poll->timer, UV_AfterPollAsync);
+}
+
+void ODBC::UV_AfterPollAsync (uv_handle_t* handle) {
+  free(handle->data);
+}
+
+/*
+ * GetParameterArrays
+ * 
+ * Convert an array of rows, each an array of parameter values, into one 
+ * column-wise array per parameter for binding with SQL_ATTR_PARAMSET_SIZE.
+ * Every value of a parameter has to be bound as the same C type, so the type
+ * is picked from all of its values: a string anywhere makes every value a 
+ * string, otherwise any fractional number makes them all doubles. Dates and
+ * Buffers are bound as timestamps and binary, and can only be mixed with 
+ * nulls.
+ * 
+ * Returns NULL and sets error if rows is not an array of arrays of the same 
+ * length, or a parameter can not be bound as one type.
+ */
+
+ParameterArray* ODBC::GetParameterArrays (Local<Array> rows, int* paramCount, const char** error) {
+  DEBUG_PRINTF("ODBC::GetParameterArrays\n");
+  int rowCount = rows->Length();
+  
+  *paramCount = 0;
+  *error = "ODBCStatement::ExecuteBatch(): Argument 0 must be a non-empty Array of Arrays which all have the same length.";
+  
+  if (rowCount == 0 || !rows->Get(0)->IsArray()) {
+    return NULL;
+  }
+  
+  *paramCount = Local<Array>::Cast(rows->Get(0))->Length();
+  
+  for (int row = 0; row < rowCount; row++) {
+    if (!rows->Get(row)->IsArray() 
+        || (int) Local<Array>::Cast(rows->Get(row))->Length() != *paramCount) {
+      *paramCount = 0;
+      
+      return NULL;
+    }
+  }
+  
+  ParameterArray* arrays = (ParameterArray *) calloc(*paramCount, sizeof(ParameterArray));
+  
+  for (int i = 0; i < *paramCount; i++) {
+    bool hasString = false;
+    bool hasDouble = false;
+    bool hasNumber = false;
+    bool hasBoolean = false;
+    bool hasDate = false;
+    bool hasBuffer = false;
+    int maxLength = 0;
+    
+    for (int row = 0; row < rowCount; row++) {
+      Local<Value> value = Local<Array>::Cast(rows->Get(row))->Get(i);
+      int length;
+      
+      if (value->IsNull() || value->IsUndefined()) {
+        continue;
+      }
+      else if (value->IsDate()) {
+        hasDate = true;
+        continue;
+      }
+      else if (Buffer::HasInstance(value)) {
+        hasBuffer = true;
+        length = Buffer::Length(value->ToObject());
+      }
+      else {
+        if (value->IsInt32()) {
+          hasNumber = true;
+        }
+        else if (value->IsNumber()) {
+          hasNumber = true;
+          hasDouble = true;
+        }
+        else if (value->IsBoolean()) {
+          hasBoolean = true;
+        }
+        else {
+          hasString = true;
+        }
+        
+#ifdef UNICODE
+        length = value->ToString()->Length();
+#else
+        length = value->ToString()->Utf8Length();
+#endif
+      }
+      
+      if (length > maxLength) {
+        maxLength = length;
+      }
+    }
+    
+    bool hasOther = hasString || hasNumber || hasBoolean;
+    
+    if ((hasDate && (hasBuffer || hasOther)) || (hasBuffer && hasOther)) {
+      *error = "ODBCStatement::ExecuteBatch(): A parameter which has a Date or a Buffer in one row must have the same type or null in every row.";
+      
+      FreeParameterArrays(arrays, i);
+      *paramCount = 0;
+      
+      return NULL;
+    }
+    
+    ParameterArray* array = &arrays[i];
+    
+    if (hasDate) {
+      array->ValueType     = SQL_C_TYPE_TIMESTAMP;
+      array->ParameterType = SQL_TYPE_TIMESTAMP;
+      array->width         = sizeof(SQL_TIMESTAMP_STRUCT);
+      array->ColumnSize    = 23;
+      array->DecimalDigits = 3;
+    }
+    else if (hasBuffer) {
+      array->ValueType     = SQL_C_BINARY;
+      array->ParameterType = SQL_VARBINARY;
+      array->width         = (maxLength > 0) ? maxLength : 1;
+      array->ColumnSize    = array->width;
+    }
+    else if (hasString) {
+      array->ValueType     = SQL_C_TCHAR;
+#ifdef UNICODE
+      array->ParameterType = SQL_WVARCHAR;
+      array->width         = (maxLength + 1) * sizeof(uint16_t);
+#else
+      array->ParameterType = SQL_VARCHAR;
+      array->width         = maxLength + 1;
+#endif
+      array->ColumnSize    = (maxLength > 0) ? maxLength : 1;
+    }
+    else if (hasDouble) {
+      array->ValueType     = SQL_C_DOUBLE;
+      array->ParameterType = SQL_DECIMAL;
+      array->width         = sizeof(double);
+      array->ColumnSize    = sizeof(double);
+      array->DecimalDigits = 7;
+    }
+    else if (hasNumber) {
+      array->ValueType     = SQL_C_SBIGINT;
+      array->ParameterType = SQL_BIGINT;
+      array->width         = sizeof(int64_t);
+    }
+    else if (hasBoolean) {
+      array->ValueType     = SQL_C_BIT;
+      array->ParameterType = SQL_BIT;
+      array->width         = sizeof(unsigned char);
+    }
+    else {
+      //every value is null
+      array->ValueType     = SQL_C_CHAR;
+      array->ParameterType = SQL_VARCHAR;
+      array->width         = 1;
+      array->ColumnSize    = 1;
+    }
+    
+    array->values = (char *) calloc(rowCount, array->width);
+    array->lengths = (SQLLEN *) malloc(rowCount * sizeof(SQLLEN));
+    
+    for (int row = 0; row < rowCount; row++) {
+      Local<Value> value = Local<Array>::Cast(rows->Get(row))->Get(i);
+      char* element = array->values + (row * array->width);
+      
+      if (value->IsNull() || value->IsUndefined()) {
+        array->lengths[row] = SQL_NULL_DATA;
+        continue;
+      }
+      
+      switch (array->ValueType) {
+        case SQL_C_TYPE_TIMESTAMP :
+          EncodeTimestamp(value, (SQL_TIMESTAMP_STRUCT *) element);
+          array->lengths[row] = sizeof(SQL_TIMESTAMP_STRUCT);
+          break;
+        case SQL_C_BINARY :
+          array->lengths[row] = Buffer::Length(value->ToObject());
+          memcpy(element, Buffer::Data(value->ToObject()), array->lengths[row]);
+          break;
+        case SQL_C_TCHAR :
+#ifdef UNICODE
+          value->ToString()->Write((uint16_t *) element);
+#else
+          value->ToString()->WriteUtf8(element);
+#endif
+          array->lengths[row] = SQL_NTS;
+          break;
+        case SQL_C_DOUBLE :
+          *(double *) element = value->NumberValue();
+          array->lengths[row] = sizeof(double);
+          break;
+        case SQL_C_SBIGINT :
+          *(int64_t *) element = value->IntegerValue();
+          array->lengths[row] = 0;
+          break;
+        case SQL_C_BIT :
+          *(unsigned char *) element = value->BooleanValue() ? 1 : 0;
+          array->lengths[row] = 0;
+          break;
+      }
+    }
+    
+    DEBUG_PRINTF("ODBC::GetParameterArrays - param[%i] c_type=%i type=%i width=%i size=%i\n",
+                 i, array->ValueType, array->ParameterType, array->width, array->ColumnSize);
+  }
+  
+  return arrays;
+}
+
+void ODBC::FreeParameterArrays (ParameterArray* arrays, int paramCount) {
+  for (int i = 0; i < paramCount; i++) {
+    free(arrays[i].values);
+    free(arrays[i].lengths);
+  }
+  
+  free(arrays);
 }
 
 /*
@@ -919,6 +2589,7 @@ Local<Array> ODBC::GetAllRecordsSync (HENV hENV,
   short colCount = 0;
   
   Column* columns = GetColumns(hSTMT, &colCount);
+  Local<Object> recordTemplate = GetRecordTemplate(columns, &colCount);
   
   Local<Array> rows = NanNew<Array>();
   
@@ -956,7 +2627,8 @@ Local<Array> ODBC::GetAllRecordsSync (HENV hENV,
         columns,
         &colCount,
         buffer,
-        bufferLength)
+        bufferLength,
+        recordTemplate)
     );
 
     count++;
@@ -988,6 +2660,7 @@ extern "C" void init(v8::Handle<Object> exports) {
   ODBCResult::Init(exports);
   ODBCConnection::Init(exports);
   ODBCStatement::Init(exports);
+  ODBCWorkerPool::Init(exports);
 }
 
 NODE_MODULE(odbc_bindings, init)
@@ -33,12 +33,41 @@
 #include <sqlucode.h>
 #endif
 
+//from the ODBC 3.8 headers, for driver managers that do not have them yet
+#ifndef SQL_ATTR_RESET_CONNECTION
+#define SQL_ATTR_RESET_CONNECTION 116
+#define SQL_RESET_CONNECTION_YES 1
+#endif
+
 using namespace v8;
 using namespace node;
 
 #define MAX_FIELD_SIZE 1024
 #define MAX_VALUE_SIZE 1048576
 
+//number of rows fetched per trip to the thread pool by fetchAll
+#define DEFAULT_FETCH_SIZE 1
+//number of rows read into each block when queryAll fetches a whole result
+//on the thread pool and no larger fetchSize was asked for
+#define QUERY_ALL_BLOCK_SIZE 64
+//number of prepared statements each connection keeps for queryAll
+#define DEFAULT_STATEMENT_CACHE_SIZE 32
+//milliseconds to wait before asking the driver again whether a statement
+//executing asynchronously has finished, doubling up to the maximum
+#define ASYNC_POLL_INTERVAL 1
+#define MAX_ASYNC_POLL_INTERVAL 32
+//most rows sent to the driver in one SQLExecute by executeBatch
+#define MAX_PARAMSET_SIZE 1024
+//largest per-row buffer we are willing to bind for a block fetch
+#define MAX_BIND_COLUMN_SIZE 8192
+
+//how statement calls that the driver may not handle at the same time as
+//others are serialised: process wide, per connection or not at all
+#define LOCK_GLOBAL 1
+#define LOCK_CONNECTION 2
+#define LOCK_NONE 3
+#define DEFAULT_LOCK_MODE LOCK_CONNECTION
+
 #ifdef UNICODE
 #define ERROR_MESSAGE_BUFFER_BYTES 2048
 #define ERROR_MESSAGE_BUFFER_CHARS 1024
@@ -51,16 +80,50 @@ using namespace node;
 #define MODE_CALLBACK_FOR_EACH 2
 #define FETCH_ARRAY 3
 #define FETCH_OBJECT 4
+#define FETCH_COLUMNS 5
 #define SQL_DESTROY 9999
 
 
+//turns a value that has been copied out of the driver into a javascript value
+typedef Local<Value> (*ColumnDecoder)(char* value, SQLLEN len);
+
 typedef struct {
   unsigned char *name;
   unsigned int len;
   SQLLEN type;
   SQLUSMALLINT index;
+  SQLLEN size;
+  SQLSMALLINT cType;
+  SQLLEN bindSize;
+  ColumnDecoder decode;
+  //property name shared by every row of the result set
+  Persistent<String> *key;
 } Column;
 
+//native storage for rows that have been fetched on the thread pool but not
+//yet converted to javascript values. Each column has an array of values and
+//an array of length indicators. A column with a width of 0 holds one
+//malloc'd pointer per row for data that can not be sized up front.
+typedef struct {
+  short colCount;
+  int rowCapacity;
+  SQLULEN rowCount;
+  bool bound;
+  SQLLEN *widths;
+  char **values;
+  SQLLEN **lengths;
+} RowBlock;
+
+//the values of one column across every row fetched in FETCH_COLUMNS mode.
+//values is only used for integer and double columns; other columns are 
+//collected straight into a javascript array.
+typedef struct {
+  SQLULEN count;
+  SQLULEN capacity;
+  char *values;
+  unsigned char *nulls;
+} ColumnVector;
+
 typedef struct {
   SQLSMALLINT  ValueType;
   SQLSMALLINT  ParameterType;
@@ -69,20 +132,115 @@ typedef struct {
   void        *ParameterValuePtr;
   SQLLEN       BufferLength; 
   SQLLEN       StrLen_or_IndPtr;
+  //a Buffer whose memory is bound directly, kept alive until the parameters
+  //are freed
+  Persistent<Object> *buffer;
+  //a string which outgrew its place after the parameters were made
+  char        *grown;
+  //set when only this parameter has to be bound again
+  bool         rebind;
 } Parameter;
 
+//what the driver says one of a prepared statement's parameters is, from
+//SQLDescribeParam
+typedef struct {
+  SQLSMALLINT  DataType;
+  SQLULEN      ParameterSize;
+  SQLSMALLINT  DecimalDigits;
+} ParameterDescription;
+
+//round a parameter value's size up so the next value is aligned for any type
+#define ALIGN_PARAMETER(size) (((size) + sizeof(double) - 1) & ~(sizeof(double) - 1))
+
+//one parameter of executeBatch, bound column-wise with a value and a length
+//indicator for every row of the batch
+typedef struct {
+  SQLSMALLINT  ValueType;
+  SQLSMALLINT  ParameterType;
+  SQLLEN       ColumnSize;
+  SQLSMALLINT  DecimalDigits;
+  SQLLEN       width;
+  char        *values;
+  SQLLEN      *lengths;
+} ParameterArray;
+
+//a call to the driver made with SQL_ATTR_ASYNC_ENABLE on, which is made 
+//again until it stops returning SQL_STILL_EXECUTING
+typedef SQLRETURN (*AsyncPollCall)(uv_work_t* req);
+
+struct odbc_work_queue;
+
+//the lock shared by a connection and every statement and result made from
+//it. mode can not change once the connection is open. refs is only touched
+//on the main thread. The counters are only written while holding the mutex
+//they count but are read from the main thread without it, so they are only
+//approximate while work is running. worker is the connection's pinned 
+//worker thread, if it has one.
+typedef struct {
+  int mode;
+  uv_mutex_t mutex;
+  int refs;
+  unsigned int acquisitions;
+  unsigned int contentions;
+  odbc_work_queue *worker;
+} DriverLock;
+
+typedef struct {
+  uv_timer_t timer;
+  uv_work_t *req;
+  SQLHSTMT hStmt;
+  AsyncPollCall call;
+  uv_after_work_cb after;
+  uint64_t interval;
+  SQLRETURN result;
+} async_poll_data;
+
 class ODBC : public node::ObjectWrap {
   public:
     static Persistent<Function> constructor;
+    static Persistent<String> OPTION_VALUE;
+    static Persistent<String> OPTION_TYPE;
+    static Persistent<String> OPTION_SIZE;
+    static Persistent<String> OPTION_SCALE;
+    static Persistent<String> OPTION_LENGTH;
+    static Persistent<String> OPTION_STREAM;
     static uv_mutex_t g_odbcMutex;
     static uv_async_t g_async;
     
     static void Init(v8::Handle<Object> exports);
     static Column* GetColumns(SQLHSTMT hStmt, short* colCount);
+    static Column* DescribeColumns(SQLHSTMT hStmt, short* colCount);
+    static void CreateColumnKeys(Column* columns, short* colCount);
     static void FreeColumns(Column* columns, short* colCount);
+    static Local<Value> DecodeInteger(char* value, SQLLEN len);
+    static Local<Value> DecodeDouble(char* value, SQLLEN len);
+    static Local<Value> DecodeTimestamp(char* value, SQLLEN len);
+    static Local<Value> DecodeBit(char* value, SQLLEN len);
+    static Local<Value> DecodeBinary(char* value, SQLLEN len);
+    static Local<Value> DecodeString(char* value, SQLLEN len);
+    static void EncodeTimestamp(Local<Value> value, SQL_TIMESTAMP_STRUCT* timestamp);
+    static void FreeBufferData(char* data, void* hint);
     static Handle<Value> GetColumnValue(SQLHSTMT hStmt, Column column, uint16_t* buffer, int bufferLength);
-    static Local<Object> GetRecordTuple (SQLHSTMT hStmt, Column* columns, short* colCount, uint16_t* buffer, int bufferLength);
+    static Local<Object> GetRecordTemplate (Column* columns, short* colCount);
+    static Local<Object> GetRecordTuple (SQLHSTMT hStmt, Column* columns, short* colCount, uint16_t* buffer, int bufferLength, Local<Object> recordTemplate);
     static Handle<Value> GetRecordArray (SQLHSTMT hStmt, Column* columns, short* colCount, uint16_t* buffer, int bufferLength);
+    static RowBlock* AllocRowBlock(Column* columns, short colCount, int rowCapacity, bool bound);
+    static void ResetRowBlock(RowBlock* block);
+    static void FreeRowBlock(RowBlock* block);
+    static SQLRETURN BindRowBlock(SQLHSTMT hStmt, Column* columns, RowBlock* block);
+    static void UnbindRowBlock(SQLHSTMT hStmt);
+    static SQLRETURN FetchRowBlock(SQLHSTMT hStmt, Column* columns, RowBlock* block);
+    static SQLRETURN GetRowBlockData(SQLHSTMT hStmt, Column column, RowBlock* block, int row);
+    static SQLRETURN GetLongData(SQLHSTMT hStmt, Column column, char** value, SQLLEN* len);
+    static SQLRETURN ReadLongData(SQLHSTMT hStmt, Column column, char** value, SQLLEN capacity, SQLLEN total, SQLLEN* len);
+    static bool IsRowBlockTruncated(Column* columns, RowBlock* block);
+    static Handle<Value> GetBlockColumnValue(Column column, RowBlock* block, int row);
+    static Local<Object> GetBlockRecordTuple (Column* columns, short* colCount, RowBlock* block, int row, Local<Object> recordTemplate);
+    static Handle<Value> GetBlockRecordArray (Column* columns, short* colCount, RowBlock* block, int row);
+    static ColumnVector* AllocColumnVectors(short colCount);
+    static void FreeColumnVectors(ColumnVector* vectors, short colCount);
+    static void AppendColumnVectors(Column* columns, short* colCount, RowBlock* block, ColumnVector* vectors, Local<Array> arrays);
+    static Local<Object> GetColumnVectors(Column* columns, short* colCount, ColumnVector* vectors, Local<Array> arrays);
     static Handle<Value> CallbackSQLError(SQLSMALLINT handleType, SQLHANDLE handle, NanCallback* cb);
     static Handle<Value> CallbackSQLError (SQLSMALLINT handleType, SQLHANDLE handle, char* message, NanCallback* cb);
     static Local<Object> GetSQLError (SQLSMALLINT handleType, SQLHANDLE handle);
@@ -91,7 +249,31 @@ class ODBC : public node::ObjectWrap {
 #ifdef dynodbc
     static NAN_METHOD(LoadODBCLibrary);
 #endif
+    static bool IsParameterDescriptor (Local<Value> value);
+    static Local<Value> DescribeParameter (Local<Value> value, Parameter* param, ParameterDescription* description);
+    static void ApplyParameterDescription (Local<Value> value, Parameter* param, ParameterDescription* description);
+    static ParameterDescription* DescribeParameters (SQLHSTMT hStmt, SQLSMALLINT* count);
     static Parameter* GetParametersFromArray (Local<Array> values, int* paramCount);
+    static Parameter* GetParametersFromArray (Local<Array> values, int* paramCount, ParameterDescription* descriptions);
+    static void FreeParameters (Parameter* params, int paramCount);
+    static bool UpdateParameters (Parameter* params, int paramCount, Local<Array> values);
+    static SQLLEN GetParameterBufferLength (SQLLEN length);
+    static bool EnableAsync (SQLHSTMT hStmt);
+    static void PollAsync (uv_work_t* req, SQLHSTMT hStmt, AsyncPollCall call, uv_after_work_cb after);
+#if UV_VERSION_MAJOR >= 1
+    static void UV_PollAsync (uv_timer_t* timer);
+#else
+    static void UV_PollAsync (uv_timer_t* timer, int status);
+#endif
+    static void UV_AfterPollAsync (uv_handle_t* handle);
+    static DriverLock* CreateDriverLock (int mode);
+    static void RetainDriverLock (DriverLock* lock);
+    static void ReleaseDriverLock (DriverLock* lock);
+    static uv_mutex_t* LockDriver (DriverLock* lock);
+    static bool TryLockDriver (DriverLock* lock, uv_mutex_t** mutex);
+    static void UnlockDriver (uv_mutex_t* mutex);
+    static ParameterArray* GetParameterArrays (Local<Array> rows, int* paramCount, const char** error);
+    static void FreeParameterArrays (ParameterArray* arrays, int paramCount);
     
     void Free();
     
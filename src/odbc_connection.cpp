@@ -26,6 +26,7 @@
 #include "odbc_connection.h"
 #include "odbc_result.h"
 #include "odbc_statement.h"
+#include "odbc_worker_pool.h"
 
 using namespace v8;
 using namespace node;
@@ -34,6 +35,7 @@ Persistent<Function> ODBCConnection::constructor;
 Persistent<String> ODBCConnection::OPTION_SQL;
 Persistent<String> ODBCConnection::OPTION_PARAMS;
 Persistent<String> ODBCConnection::OPTION_NORESULTS;
+Persistent<String> ODBCConnection::OPTION_TIMEOUT;
 
 void ODBCConnection::Init(v8::Handle<Object> exports) {
   DEBUG_PRINTF("ODBCConnection::Init\n");
@@ -42,6 +44,7 @@ void ODBCConnection::Init(v8::Handle<Object> exports) {
   NanAssignPersistent(OPTION_SQL, NanNew<String>("sql"));
   NanAssignPersistent(OPTION_PARAMS, NanNew<String>("params"));
   NanAssignPersistent(OPTION_NORESULTS, NanNew<String>("noResults"));
+  NanAssignPersistent(OPTION_TIMEOUT, NanNew<String>("timeout"));
 
   Local<FunctionTemplate> constructor_template = NanNew<FunctionTemplate>(New);
 
@@ -57,16 +60,30 @@ void ODBCConnection::Init(v8::Handle<Object> exports) {
   instance_template->SetAccessor(NanNew("connected"), ConnectedGetter);
   instance_template->SetAccessor(NanNew("connectTimeout"), ConnectTimeoutGetter, ConnectTimeoutSetter);
   instance_template->SetAccessor(NanNew("loginTimeout"), LoginTimeoutGetter, LoginTimeoutSetter);
+  instance_template->SetAccessor(NanNew("statementCacheSize"), StatementCacheSizeGetter, StatementCacheSizeSetter);
+  instance_template->SetAccessor(NanNew("statementCacheHits"), StatementCacheHitsGetter);
+  instance_template->SetAccessor(NanNew("statementCacheMisses"), StatementCacheMissesGetter);
+  instance_template->SetAccessor(NanNew("asyncPolling"), AsyncPollingGetter, AsyncPollingSetter);
+  instance_template->SetAccessor(NanNew("queryTimeout"), QueryTimeoutGetter, QueryTimeoutSetter);
+  instance_template->SetAccessor(NanNew("lockMode"), LockModeGetter, LockModeSetter);
+  instance_template->SetAccessor(NanNew("lockAcquisitions"), LockAcquisitionsGetter);
+  instance_template->SetAccessor(NanNew("lockContentions"), LockContentionsGetter);
+  instance_template->SetAccessor(NanNew("pinnedWorker"), PinnedWorkerGetter, PinnedWorkerSetter);
   
   // Prototype Methods
   NODE_SET_PROTOTYPE_METHOD(constructor_template, "open", Open);
   NODE_SET_PROTOTYPE_METHOD(constructor_template, "openSync", OpenSync);
   NODE_SET_PROTOTYPE_METHOD(constructor_template, "close", Close);
   NODE_SET_PROTOTYPE_METHOD(constructor_template, "closeSync", CloseSync);
+  NODE_SET_PROTOTYPE_METHOD(constructor_template, "reset", Reset);
+  NODE_SET_PROTOTYPE_METHOD(constructor_template, "resetSync", ResetSync);
+  NODE_SET_PROTOTYPE_METHOD(constructor_template, "validate", Validate);
+  NODE_SET_PROTOTYPE_METHOD(constructor_template, "validateSync", ValidateSync);
   NODE_SET_PROTOTYPE_METHOD(constructor_template, "createStatement", CreateStatement);
   NODE_SET_PROTOTYPE_METHOD(constructor_template, "createStatementSync", CreateStatementSync);
   NODE_SET_PROTOTYPE_METHOD(constructor_template, "query", Query);
   NODE_SET_PROTOTYPE_METHOD(constructor_template, "querySync", QuerySync);
+  NODE_SET_PROTOTYPE_METHOD(constructor_template, "queryAll", QueryAll);
   
   NODE_SET_PROTOTYPE_METHOD(constructor_template, "beginTransaction", BeginTransaction);
   NODE_SET_PROTOTYPE_METHOD(constructor_template, "beginTransactionSync", BeginTransactionSync);
@@ -84,15 +101,36 @@ void ODBCConnection::Init(v8::Handle<Object> exports) {
 ODBCConnection::~ODBCConnection() {
   DEBUG_PRINTF("ODBCConnection::~ODBCConnection\n");
   this->Free();
+  
+  ODBC::ReleaseDriverLock(m_lock);
 }
 
 void ODBCConnection::Free() {
   DEBUG_PRINTF("ODBCConnection::Free\n");
+  
+  //the cached statements have to go before the connection does
+  while (m_statementCacheCount > 0) {
+    FreeCachedStatement(m_statementCacheCount - 1);
+  }
+  
+  free(m_statementCache);
+  m_statementCache = NULL;
+  
   if (m_hDBC) {
+    //disconnecting may wait on the network, so only a driver that is not
+    //thread safe holds everyone else up for it
+    uv_mutex_t* locked = (m_lock->mode == LOCK_GLOBAL)
+      ? ODBC::LockDriver(m_lock)
+      : NULL;
+    
+    SQLDisconnect(m_hDBC);
+    
+    ODBC::UnlockDriver(locked);
+    
+    //the connection handle belongs to the environment
     uv_mutex_lock(&ODBC::g_odbcMutex);
     
     if (m_hDBC) {
-      SQLDisconnect(m_hDBC);
       SQLFreeHandle(SQL_HANDLE_DBC, m_hDBC);
       m_hDBC = NULL;
     }
@@ -119,10 +157,27 @@ NAN_METHOD(ODBCConnection::New) {
   
   conn->Wrap(args.Holder());
   
+  conn->connected = false;
+  
   //set default connectTimeout to 0 seconds
   conn->connectTimeout = 0;
   //set default loginTimeout to 5 seconds
   conn->loginTimeout = 5;
+  
+  conn->m_statementCache = NULL;
+  conn->m_statementCacheCount = 0;
+  conn->m_statementCacheSize = DEFAULT_STATEMENT_CACHE_SIZE;
+  conn->m_statementCacheClock = 0;
+  conn->m_statementCacheHits = 0;
+  conn->m_statementCacheMisses = 0;
+  
+  conn->asyncPolling = false;
+  
+  //set default queryTimeout to 0 seconds (no timeout)
+  conn->queryTimeout = 0;
+  
+  //statements and results made from this connection share its lock
+  conn->m_lock = ODBC::CreateDriverLock(DEFAULT_LOCK_MODE);
 
   NanReturnValue(args.Holder());
 }
@@ -171,6 +226,150 @@ NAN_SETTER(ODBCConnection::LoginTimeoutSetter) {
   }
 }
 
+NAN_GETTER(ODBCConnection::StatementCacheSizeGetter) {
+  NanScope();
+
+  ODBCConnection *obj = ObjectWrap::Unwrap<ODBCConnection>(args.Holder());
+
+  NanReturnValue(NanNew<Number>(obj->m_statementCacheSize));
+}
+
+NAN_SETTER(ODBCConnection::StatementCacheSizeSetter) {
+  NanScope();
+
+  ODBCConnection *obj = ObjectWrap::Unwrap<ODBCConnection>(args.Holder());
+  
+  if (value->IsNumber()) {
+    obj->m_statementCacheSize = value->Uint32Value();
+    obj->TrimStatementCache();
+  }
+}
+
+NAN_GETTER(ODBCConnection::StatementCacheHitsGetter) {
+  NanScope();
+
+  ODBCConnection *obj = ObjectWrap::Unwrap<ODBCConnection>(args.Holder());
+
+  NanReturnValue(NanNew<Number>(obj->m_statementCacheHits));
+}
+
+NAN_GETTER(ODBCConnection::StatementCacheMissesGetter) {
+  NanScope();
+
+  ODBCConnection *obj = ObjectWrap::Unwrap<ODBCConnection>(args.Holder());
+
+  NanReturnValue(NanNew<Number>(obj->m_statementCacheMisses));
+}
+
+NAN_GETTER(ODBCConnection::AsyncPollingGetter) {
+  NanScope();
+
+  ODBCConnection *obj = ObjectWrap::Unwrap<ODBCConnection>(args.Holder());
+
+  NanReturnValue(NanNew<Boolean>(obj->asyncPolling));
+}
+
+NAN_SETTER(ODBCConnection::AsyncPollingSetter) {
+  NanScope();
+
+  ODBCConnection *obj = ObjectWrap::Unwrap<ODBCConnection>(args.Holder());
+  
+  obj->asyncPolling = value->BooleanValue();
+}
+
+NAN_GETTER(ODBCConnection::QueryTimeoutGetter) {
+  NanScope();
+
+  ODBCConnection *obj = ObjectWrap::Unwrap<ODBCConnection>(args.Holder());
+
+  NanReturnValue(NanNew<Number>(obj->queryTimeout));
+}
+
+NAN_SETTER(ODBCConnection::QueryTimeoutSetter) {
+  NanScope();
+
+  ODBCConnection *obj = ObjectWrap::Unwrap<ODBCConnection>(args.Holder());
+  
+  if (value->IsNumber()) {
+    obj->queryTimeout = value->Uint32Value();
+  }
+}
+
+NAN_GETTER(ODBCConnection::LockModeGetter) {
+  NanScope();
+
+  ODBCConnection *obj = ObjectWrap::Unwrap<ODBCConnection>(args.Holder());
+
+  NanReturnValue(NanNew<Number>(obj->m_lock->mode));
+}
+
+NAN_SETTER(ODBCConnection::LockModeSetter) {
+  NanScope();
+
+  ODBCConnection *obj = ObjectWrap::Unwrap<ODBCConnection>(args.Holder());
+  
+  //work already running on other threads took the mutex of the old mode;
+  //changing it under them would let new work run alongside it. Statements
+  //and results hold references to the lock, so none being left means none
+  //of their work is running.
+  if (obj->connected || obj->m_lock->refs > 1) {
+    NanThrowError("[node-odbc] lockMode can only be set before the connection is opened");
+    
+    return;
+  }
+  
+  if (value->IsInt32()) {
+    int mode = value->Int32Value();
+    
+    if (mode == LOCK_GLOBAL || mode == LOCK_CONNECTION || mode == LOCK_NONE) {
+      obj->m_lock->mode = mode;
+    }
+  }
+}
+
+NAN_GETTER(ODBCConnection::LockAcquisitionsGetter) {
+  NanScope();
+
+  ODBCConnection *obj = ObjectWrap::Unwrap<ODBCConnection>(args.Holder());
+
+  NanReturnValue(NanNew<Number>(obj->m_lock->acquisitions));
+}
+
+NAN_GETTER(ODBCConnection::LockContentionsGetter) {
+  NanScope();
+
+  ODBCConnection *obj = ObjectWrap::Unwrap<ODBCConnection>(args.Holder());
+
+  NanReturnValue(NanNew<Number>(obj->m_lock->contentions));
+}
+
+NAN_GETTER(ODBCConnection::PinnedWorkerGetter) {
+  NanScope();
+
+  ODBCConnection *obj = ObjectWrap::Unwrap<ODBCConnection>(args.Holder());
+
+  NanReturnValue(NanNew<Boolean>(obj->m_lock->worker != NULL));
+}
+
+NAN_SETTER(ODBCConnection::PinnedWorkerSetter) {
+  NanScope();
+
+  ODBCConnection *obj = ObjectWrap::Unwrap<ODBCConnection>(args.Holder());
+  
+  //with a pinned worker all of the work for this connection and its 
+  //statements and results is done on one thread of its own. Turning it off
+  //lets that thread finish whatever has already been queued to it before
+  //it goes away.
+  if (value->BooleanValue() && obj->m_lock->worker == NULL) {
+    obj->m_lock->worker = ODBCWorkerPool::CreateQueue(1);
+  }
+  else if (!value->BooleanValue() && obj->m_lock->worker != NULL) {
+    ODBCWorkerPool::DestroyQueue(obj->m_lock->worker);
+    
+    obj->m_lock->worker = NULL;
+  }
+}
+
 /*
  * Open
  * 
@@ -211,7 +410,7 @@ NAN_METHOD(ODBCConnection::Open) {
   work_req->data = data;
   
   //queue the work
-  uv_queue_work(uv_default_loop(), 
+  ODBCWorkerPool::Queue(conn->m_lock, 
     work_req, 
     UV_Open, 
     (uv_after_work_cb)UV_AfterOpen);
@@ -229,7 +428,7 @@ void ODBCConnection::UV_Open(uv_work_t* req) {
 
   DEBUG_PRINTF("ODBCConnection::UV_Open : connectTimeout=%i, loginTimeout = %i\n", *&(self->connectTimeout), *&(self->loginTimeout));
   
-  uv_mutex_lock(&ODBC::g_odbcMutex); 
+  uv_mutex_t* locked = ODBC::LockDriver(self->m_lock);
   
   if (self->connectTimeout > 0) {
     //NOTE: SQLSetConnectAttr requires the thread to be locked
@@ -249,8 +448,15 @@ void ODBCConnection::UV_Open(uv_work_t* req) {
       SQL_IS_UINTEGER);                        //StringLength
   }
   
-  //Attempt to connect
-  //NOTE: SQLDriverConnect requires the thread to be locked
+  ODBC::UnlockDriver(locked);
+  
+  //Attempt to connect. This is where the time goes (network, TLS, login)
+  //so other connections may connect at the same time unless the driver is
+  //not thread safe
+  locked = (self->m_lock->mode == LOCK_GLOBAL)
+    ? ODBC::LockDriver(self->m_lock)
+    : NULL;
+  
   int ret = SQLDriverConnect(
     self->m_hDBC,                   //ConnectionHandle
     NULL,                           //WindowHandle
@@ -261,9 +467,13 @@ void ODBCConnection::UV_Open(uv_work_t* req) {
     NULL,                           //StringLength2Ptr
     SQL_DRIVER_NOPROMPT);           //DriverCompletion
   
+  ODBC::UnlockDriver(locked);
+  
   if (SQL_SUCCEEDED(ret)) {
     HSTMT hStmt;
     
+    locked = ODBC::LockDriver(self->m_lock);
+    
     //allocate a temporary statment
     ret = SQLAllocHandle(SQL_HANDLE_STMT, self->m_hDBC, &hStmt);
     
@@ -280,9 +490,9 @@ void ODBCConnection::UV_Open(uv_work_t* req) {
     
     //free the handle
     ret = SQLFreeHandle( SQL_HANDLE_STMT, hStmt);
+    
+    ODBC::UnlockDriver(locked);
   }
-
-  uv_mutex_unlock(&ODBC::g_odbcMutex);
   
   data->result = ret;
 }
@@ -361,7 +571,7 @@ NAN_METHOD(ODBCConnection::OpenSync) {
   connection->WriteUtf8(connectionString);
 #endif
   
-  uv_mutex_lock(&ODBC::g_odbcMutex);
+  uv_mutex_t* locked = ODBC::LockDriver(conn->m_lock);
   
   if (conn->connectTimeout > 0) {
     //NOTE: SQLSetConnectAttr requires the thread to be locked
@@ -381,8 +591,14 @@ NAN_METHOD(ODBCConnection::OpenSync) {
       SQL_IS_UINTEGER);                        //StringLength
   }
   
-  //Attempt to connect
-  //NOTE: SQLDriverConnect requires the thread to be locked
+  ODBC::UnlockDriver(locked);
+  
+  //Attempt to connect, holding up other connections only for a driver
+  //that is not thread safe
+  locked = (conn->m_lock->mode == LOCK_GLOBAL)
+    ? ODBC::LockDriver(conn->m_lock)
+    : NULL;
+  
   ret = SQLDriverConnect(
     conn->m_hDBC,                   //ConnectionHandle
     NULL,                           //WindowHandle
@@ -392,6 +608,8 @@ NAN_METHOD(ODBCConnection::OpenSync) {
     0,                              //BufferLength - in characters
     NULL,                           //StringLength2Ptr
     SQL_DRIVER_NOPROMPT);           //DriverCompletion
+  
+  ODBC::UnlockDriver(locked);
 
   if (!SQL_SUCCEEDED(ret)) {
     err = true;
@@ -401,6 +619,8 @@ NAN_METHOD(ODBCConnection::OpenSync) {
   else {
     HSTMT hStmt;
     
+    locked = ODBC::LockDriver(conn->m_lock);
+    
     //allocate a temporary statment
     ret = SQLAllocHandle(SQL_HANDLE_STMT, conn->m_hDBC, &hStmt);
     
@@ -418,6 +638,8 @@ NAN_METHOD(ODBCConnection::OpenSync) {
     //free the handle
     ret = SQLFreeHandle( SQL_HANDLE_STMT, hStmt);
     
+    ODBC::UnlockDriver(locked);
+    
     conn->self()->connected = true;
     
     //only uv_ref if the connection was successful
@@ -428,8 +650,6 @@ NAN_METHOD(ODBCConnection::OpenSync) {
     #endif*/
   }
 
-  uv_mutex_unlock(&ODBC::g_odbcMutex);
-
   free(connectionString);
   
   if (err) {
@@ -463,8 +683,8 @@ NAN_METHOD(ODBCConnection::Close) {
 
   work_req->data = data;
   
-  uv_queue_work(
-    uv_default_loop(),
+  ODBCWorkerPool::Queue(
+    conn->m_lock,
     work_req,
     UV_Close,
     (uv_after_work_cb)UV_AfterClose);
@@ -555,133 +775,133 @@ NAN_METHOD(ODBCConnection::CloseSync) {
 }
 
 /*
- * CreateStatementSync
+ * Reset
  * 
+ * Put the connection back the way it was when it was opened, so that it can
+ * be used by someone else without reconnecting: a transaction that was left
+ * open is rolled back and autocommit is turned back on. Drivers that 
+ * support SQL_ATTR_RESET_CONNECTION (SQL Server's do) also drop temp tables
+ * and session settings before the connection is next used.
  */
 
-NAN_METHOD(ODBCConnection::CreateStatementSync) {
-  DEBUG_PRINTF("ODBCConnection::CreateStatementSync\n");
+NAN_METHOD(ODBCConnection::Reset) {
+  DEBUG_PRINTF("ODBCConnection::Reset\n");
   NanScope();
 
-  ODBCConnection* conn = ObjectWrap::Unwrap<ODBCConnection>(args.Holder());
-   
-  HSTMT hSTMT;
+  REQ_FUN_ARG(0, cb);
 
-  uv_mutex_lock(&ODBC::g_odbcMutex);
-  
-  SQLAllocHandle(
-    SQL_HANDLE_STMT, 
-    conn->m_hDBC, 
-    &hSTMT);
-  
-  uv_mutex_unlock(&ODBC::g_odbcMutex);
+  ODBCConnection* conn = ObjectWrap::Unwrap<ODBCConnection>(args.Holder());
   
-  Local<Value> params[3];
-  params[0] = NanNew<External>(conn->m_hENV);
-  params[1] = NanNew<External>(conn->m_hDBC);
-  params[2] = NanNew<External>(hSTMT);
+  uv_work_t* work_req = (uv_work_t *) (calloc(1, sizeof(uv_work_t)));
   
-  Local<Object> js_result(NanNew<Function>(ODBCStatement::constructor)->NewInstance(3, params));
+  reset_connection_work_data* data = (reset_connection_work_data *) 
+    (calloc(1, sizeof(reset_connection_work_data)));
+
+  data->cb = new NanCallback(cb);
+  data->conn = conn;
+  data->validate = false;
+
+  work_req->data = data;
   
-  NanReturnValue(js_result);
+  ODBCWorkerPool::Queue(
+    conn->m_lock,
+    work_req,
+    UV_Reset,
+    (uv_after_work_cb)UV_AfterReset);
+
+  conn->Ref();
+
+  NanReturnValue(NanUndefined());
 }
 
 /*
- * CreateStatement
+ * Validate
  * 
+ * Call back with whether the driver still thinks the connection is alive
+ * (SQL_ATTR_CONNECTION_DEAD). The driver answers from what it last saw, 
+ * without a round trip to the server. Drivers that can not tell say it is.
  */
 
-NAN_METHOD(ODBCConnection::CreateStatement) {
-  DEBUG_PRINTF("ODBCConnection::CreateStatement\n");
+NAN_METHOD(ODBCConnection::Validate) {
+  DEBUG_PRINTF("ODBCConnection::Validate\n");
   NanScope();
 
   REQ_FUN_ARG(0, cb);
 
   ODBCConnection* conn = ObjectWrap::Unwrap<ODBCConnection>(args.Holder());
-    
-  //initialize work request
+  
   uv_work_t* work_req = (uv_work_t *) (calloc(1, sizeof(uv_work_t)));
   
-  //initialize our data
-  create_statement_work_data* data = 
-    (create_statement_work_data *) (calloc(1, sizeof(create_statement_work_data)));
+  reset_connection_work_data* data = (reset_connection_work_data *) 
+    (calloc(1, sizeof(reset_connection_work_data)));
 
   data->cb = new NanCallback(cb);
   data->conn = conn;
+  data->validate = true;
 
   work_req->data = data;
   
-  uv_queue_work(
-    uv_default_loop(), 
-    work_req, 
-    UV_CreateStatement, 
-    (uv_after_work_cb)UV_AfterCreateStatement);
+  ODBCWorkerPool::Queue(
+    conn->m_lock,
+    work_req,
+    UV_Reset,
+    (uv_after_work_cb)UV_AfterReset);
 
   conn->Ref();
 
   NanReturnValue(NanUndefined());
 }
 
-void ODBCConnection::UV_CreateStatement(uv_work_t* req) {
-  DEBUG_PRINTF("ODBCConnection::UV_CreateStatement\n");
-  
-  //get our work data
-  create_statement_work_data* data = (create_statement_work_data *)(req->data);
-
-  DEBUG_PRINTF("ODBCConnection::UV_CreateStatement m_hDBC=%X m_hDBC=%X m_hSTMT=%X\n",
-    data->conn->m_hENV,
-    data->conn->m_hDBC,
-    data->hSTMT
-  );
-  
-  uv_mutex_lock(&ODBC::g_odbcMutex);
-  
-  //allocate a new statment handle
-  SQLAllocHandle( SQL_HANDLE_STMT, 
-                  data->conn->m_hDBC, 
-                  &data->hSTMT);
-
-  uv_mutex_unlock(&ODBC::g_odbcMutex);
+void ODBCConnection::UV_Reset(uv_work_t* req) {
+  DEBUG_PRINTF("ODBCConnection::UV_Reset\n");
+  reset_connection_work_data* data = (reset_connection_work_data *)(req->data);
+  ODBCConnection* conn = data->conn;
   
-  DEBUG_PRINTF("ODBCConnection::UV_CreateStatement m_hDBC=%X m_hDBC=%X m_hSTMT=%X\n",
-    data->conn->m_hENV,
-    data->conn->m_hDBC,
-    data->hSTMT
-  );
+  if (data->validate) {
+    data->alive = conn->IsAlive();
+    data->result = SQL_SUCCESS;
+  }
+  else {
+    data->result = conn->ResetConnection();
+  }
 }
 
-void ODBCConnection::UV_AfterCreateStatement(uv_work_t* req, int status) {
-  DEBUG_PRINTF("ODBCConnection::UV_AfterCreateStatement\n");
+void ODBCConnection::UV_AfterReset(uv_work_t* req, int status) {
+  DEBUG_PRINTF("ODBCConnection::UV_AfterReset\n");
   NanScope();
 
-  create_statement_work_data* data = (create_statement_work_data *)(req->data);
+  reset_connection_work_data* data = (reset_connection_work_data *)(req->data);
 
-  DEBUG_PRINTF("ODBCConnection::UV_AfterCreateStatement m_hDBC=%X m_hDBC=%X hSTMT=%X\n",
-    data->conn->m_hENV,
-    data->conn->m_hDBC,
-    data->hSTMT
-  );
+  ODBCConnection* conn = data->conn;
   
-  Local<Value> args[3];
-  args[0] = NanNew<External>(data->conn->m_hENV);
-  args[1] = NanNew<External>(data->conn->m_hDBC);
-  args[2] = NanNew<External>(data->hSTMT);
+  Local<Value> argv[2];
+  int argc = 1;
   
-  Local<Object> js_result = NanNew<Function>(ODBCStatement::constructor)->NewInstance(3, args);
-
-  args[0] = NanNew<Value>(NanNull());
-  args[1] = NanNew(js_result);
-
+  if (!SQL_SUCCEEDED(data->result)) {
+    argv[0] = ODBC::GetSQLError(
+      SQL_HANDLE_DBC, 
+      conn->m_hDBC,
+      (char *) "[node-odbc] Error in ODBCConnection::UV_AfterReset");
+  }
+  else {
+    argv[0] = NanNull();
+    
+    if (data->validate) {
+      argv[1] = NanNew<Boolean>(data->alive);
+      argc = 2;
+    }
+  }
 
   TryCatch try_catch;
 
-  data->cb->Call( 2, args);
+  data->cb->Call(argc, argv);
 
   if (try_catch.HasCaught()) {
     FatalException(try_catch);
   }
   
-  data->conn->Unref();
+  conn->Unref();
+
   delete data->cb;
 
   free(data);
@@ -689,29 +909,284 @@ void ODBCConnection::UV_AfterCreateStatement(uv_work_t* req, int status) {
 }
 
 /*
- * Query
+ * ResetSync
  */
 
-NAN_METHOD(ODBCConnection::Query) {
-  DEBUG_PRINTF("ODBCConnection::Query\n");
+NAN_METHOD(ODBCConnection::ResetSync) {
+  DEBUG_PRINTF("ODBCConnection::ResetSync\n");
   NanScope();
+
+  ODBCConnection* conn = ObjectWrap::Unwrap<ODBCConnection>(args.Holder());
   
-  Local<Function> cb;
+  SQLRETURN ret = conn->ResetConnection();
   
-  Local<String> sql;
+  if (!SQL_SUCCEEDED(ret)) {
+    NanThrowError(ODBC::GetSQLError(
+      SQL_HANDLE_DBC, 
+      conn->m_hDBC,
+      (char *) "[node-odbc] Error in ODBCConnection::ResetSync"));
+    
+    NanReturnValue(NanFalse());
+  }
   
+  NanReturnValue(NanTrue());
+}
+
+/*
+ * ValidateSync
+ */
+
+NAN_METHOD(ODBCConnection::ValidateSync) {
+  DEBUG_PRINTF("ODBCConnection::ValidateSync\n");
+  NanScope();
+
   ODBCConnection* conn = ObjectWrap::Unwrap<ODBCConnection>(args.Holder());
   
-  uv_work_t* work_req = (uv_work_t *) (calloc(1, sizeof(uv_work_t)));
-  
-  query_work_data* data = (query_work_data *) calloc(1, sizeof(query_work_data));
+  NanReturnValue(NanNew<Boolean>(conn->IsAlive()));
+}
 
-  //Check arguments for different variations of calling this function
-  if (args.Length() == 3) {
-    //handle Query("sql string", [params], function cb () {});
+SQLRETURN ODBCConnection::ResetConnection() {
+  DEBUG_PRINTF("ODBCConnection::ResetConnection\n");
+  
+  SQLRETURN ret;
+  SQLUINTEGER autoCommit = SQL_AUTOCOMMIT_ON;
+  
+  if (!connected) {
+    return SQL_ERROR;
+  }
+  
+  uv_mutex_t* locked = ODBC::LockDriver(m_lock);
+  
+  ret = SQLGetConnectAttr(
+    m_hDBC,
+    SQL_ATTR_AUTOCOMMIT,
+    &autoCommit,
+    SQL_IS_UINTEGER,
+    NULL);
+  
+  //a transaction was left open; throw it away
+  if (SQL_SUCCEEDED(ret) && autoCommit == SQL_AUTOCOMMIT_OFF) {
+    ret = SQLEndTran(SQL_HANDLE_DBC, m_hDBC, SQL_ROLLBACK);
     
-    if ( !args[0]->IsString() ) {
-      return NanThrowTypeError("Argument 0 must be an String.");
+    if (SQL_SUCCEEDED(ret)) {
+      ret = SQLSetConnectAttr(
+        m_hDBC,
+        SQL_ATTR_AUTOCOMMIT,
+        (SQLPOINTER) SQL_AUTOCOMMIT_ON,
+        SQL_NTS);
+    }
+  }
+  
+  if (SQL_SUCCEEDED(ret)) {
+    //drivers that do not know this attribute just say so; there is nothing
+    //more we can do for them short of reconnecting
+    SQLSetConnectAttr(
+      m_hDBC,
+      SQL_ATTR_RESET_CONNECTION,
+      (SQLPOINTER) SQL_RESET_CONNECTION_YES,
+      SQL_IS_UINTEGER);
+  }
+  
+  ODBC::UnlockDriver(locked);
+  
+  return ret;
+}
+
+bool ODBCConnection::IsAlive() {
+  SQLUINTEGER dead = SQL_CD_FALSE;
+  
+  if (!connected) {
+    return false;
+  }
+  
+  uv_mutex_t* locked = ODBC::LockDriver(m_lock);
+  
+  SQLRETURN ret = SQLGetConnectAttr(
+    m_hDBC,
+    SQL_ATTR_CONNECTION_DEAD,
+    &dead,
+    SQL_IS_UINTEGER,
+    NULL);
+  
+  ODBC::UnlockDriver(locked);
+  
+  return !SQL_SUCCEEDED(ret) || dead == SQL_CD_FALSE;
+}
+
+/*
+ * CreateStatementSync
+ * 
+ */
+
+NAN_METHOD(ODBCConnection::CreateStatementSync) {
+  DEBUG_PRINTF("ODBCConnection::CreateStatementSync\n");
+  NanScope();
+
+  ODBCConnection* conn = ObjectWrap::Unwrap<ODBCConnection>(args.Holder());
+   
+  HSTMT hSTMT;
+
+  uv_mutex_t* locked = ODBC::LockDriver(conn->m_lock);
+  
+  SQLAllocHandle(
+    SQL_HANDLE_STMT, 
+    conn->m_hDBC, 
+    &hSTMT);
+  
+  ODBC::UnlockDriver(locked);
+  
+  Local<Value> params[4];
+  params[0] = NanNew<External>(conn->m_hENV);
+  params[1] = NanNew<External>(conn->m_hDBC);
+  params[2] = NanNew<External>(hSTMT);
+  params[3] = NanNew<External>(conn->m_lock);
+  
+  Local<Object> js_result(NanNew<Function>(ODBCStatement::constructor)->NewInstance(4, params));
+  
+  js_result->Set(NanNew("asyncPolling"), NanNew<Boolean>(conn->asyncPolling));
+  
+  if (conn->queryTimeout > 0) {
+    js_result->Set(NanNew("queryTimeout"), NanNew<Number>(conn->queryTimeout));
+  }
+  
+  NanReturnValue(js_result);
+}
+
+/*
+ * CreateStatement
+ * 
+ */
+
+NAN_METHOD(ODBCConnection::CreateStatement) {
+  DEBUG_PRINTF("ODBCConnection::CreateStatement\n");
+  NanScope();
+
+  REQ_FUN_ARG(0, cb);
+
+  ODBCConnection* conn = ObjectWrap::Unwrap<ODBCConnection>(args.Holder());
+    
+  //initialize work request
+  uv_work_t* work_req = (uv_work_t *) (calloc(1, sizeof(uv_work_t)));
+  
+  //initialize our data
+  create_statement_work_data* data = 
+    (create_statement_work_data *) (calloc(1, sizeof(create_statement_work_data)));
+
+  data->cb = new NanCallback(cb);
+  data->conn = conn;
+
+  work_req->data = data;
+  
+  ODBCWorkerPool::Queue(
+    conn->m_lock, 
+    work_req, 
+    UV_CreateStatement, 
+    (uv_after_work_cb)UV_AfterCreateStatement);
+
+  conn->Ref();
+
+  NanReturnValue(NanUndefined());
+}
+
+void ODBCConnection::UV_CreateStatement(uv_work_t* req) {
+  DEBUG_PRINTF("ODBCConnection::UV_CreateStatement\n");
+  
+  //get our work data
+  create_statement_work_data* data = (create_statement_work_data *)(req->data);
+
+  DEBUG_PRINTF("ODBCConnection::UV_CreateStatement m_hDBC=%X m_hDBC=%X m_hSTMT=%X\n",
+    data->conn->m_hENV,
+    data->conn->m_hDBC,
+    data->hSTMT
+  );
+  
+  uv_mutex_t* locked = ODBC::LockDriver(data->conn->m_lock);
+  
+  //allocate a new statment handle
+  SQLAllocHandle( SQL_HANDLE_STMT, 
+                  data->conn->m_hDBC, 
+                  &data->hSTMT);
+
+  ODBC::UnlockDriver(locked);
+  
+  DEBUG_PRINTF("ODBCConnection::UV_CreateStatement m_hDBC=%X m_hDBC=%X m_hSTMT=%X\n",
+    data->conn->m_hENV,
+    data->conn->m_hDBC,
+    data->hSTMT
+  );
+}
+
+void ODBCConnection::UV_AfterCreateStatement(uv_work_t* req, int status) {
+  DEBUG_PRINTF("ODBCConnection::UV_AfterCreateStatement\n");
+  NanScope();
+
+  create_statement_work_data* data = (create_statement_work_data *)(req->data);
+
+  DEBUG_PRINTF("ODBCConnection::UV_AfterCreateStatement m_hDBC=%X m_hDBC=%X hSTMT=%X\n",
+    data->conn->m_hENV,
+    data->conn->m_hDBC,
+    data->hSTMT
+  );
+  
+  Local<Value> args[4];
+  args[0] = NanNew<External>(data->conn->m_hENV);
+  args[1] = NanNew<External>(data->conn->m_hDBC);
+  args[2] = NanNew<External>(data->hSTMT);
+  args[3] = NanNew<External>(data->conn->m_lock);
+  
+  Local<Object> js_result = NanNew<Function>(ODBCStatement::constructor)->NewInstance(4, args);
+  
+  js_result->Set(NanNew("asyncPolling"), NanNew<Boolean>(data->conn->asyncPolling));
+  
+  if (data->conn->queryTimeout > 0) {
+    js_result->Set(NanNew("queryTimeout"), NanNew<Number>(data->conn->queryTimeout));
+  }
+
+  args[0] = NanNew<Value>(NanNull());
+  args[1] = NanNew(js_result);
+
+
+  TryCatch try_catch;
+
+  data->cb->Call( 2, args);
+
+  if (try_catch.HasCaught()) {
+    FatalException(try_catch);
+  }
+  
+  data->conn->Unref();
+  delete data->cb;
+
+  free(data);
+  free(req);
+}
+
+/*
+ * Query
+ */
+
+NAN_METHOD(ODBCConnection::Query) {
+  DEBUG_PRINTF("ODBCConnection::Query\n");
+  NanScope();
+  
+  Local<Function> cb;
+  
+  Local<String> sql;
+  
+  ODBCConnection* conn = ObjectWrap::Unwrap<ODBCConnection>(args.Holder());
+  
+  uv_work_t* work_req = (uv_work_t *) (calloc(1, sizeof(uv_work_t)));
+  
+  query_work_data* data = (query_work_data *) calloc(1, sizeof(query_work_data));
+  
+  data->timeout = conn->queryTimeout;
+
+  //Check arguments for different variations of calling this function
+  if (args.Length() == 3) {
+    //handle Query("sql string", [params], function cb () {});
+    
+    if ( !args[0]->IsString() ) {
+      return NanThrowTypeError("Argument 0 must be an String.");
     }
     else if ( !args[1]->IsArray() ) {
       return NanThrowTypeError("Argument 1 must be an Array.");
@@ -777,6 +1252,11 @@ NAN_METHOD(ODBCConnection::Query) {
       else {
         data->noResultObject = false;
       }
+      
+      Local<String> optionTimeoutKey = NanNew(OPTION_TIMEOUT);
+      if (obj->Has(optionTimeoutKey) && obj->Get(optionTimeoutKey)->IsNumber()) {
+        data->timeout = obj->Get(optionTimeoutKey)->Uint32Value();
+      }
     }
     else {
       return NanThrowTypeError("ODBCConnection::Query(): Argument 0 must be a String or an Object.");
@@ -806,11 +1286,14 @@ NAN_METHOD(ODBCConnection::Query) {
   data->conn = conn;
   work_req->data = data;
   
-  uv_queue_work(
-    uv_default_loop(),
-    work_req, 
-    UV_Query, 
-    (uv_after_work_cb)UV_AfterQuery);
+  if (!conn->asyncPolling 
+      || !conn->StartQueryAsync(work_req, (uv_after_work_cb)UV_AfterQuery)) {
+    ODBCWorkerPool::Queue(
+      conn->m_lock,
+      work_req, 
+      UV_Query, 
+      (uv_after_work_cb)UV_AfterQuery);
+  }
 
   conn->Ref();
 
@@ -825,14 +1308,21 @@ void ODBCConnection::UV_Query(uv_work_t* req) {
   Parameter prm;
   SQLRETURN ret;
   
-  uv_mutex_lock(&ODBC::g_odbcMutex);
+  uv_mutex_t* locked = ODBC::LockDriver(data->conn->m_lock);
 
   //allocate a new statment handle
   SQLAllocHandle( SQL_HANDLE_STMT, 
                   data->conn->m_hDBC, 
                   &data->hSTMT );
 
-  uv_mutex_unlock(&ODBC::g_odbcMutex);
+  ODBC::UnlockDriver(locked);
+  
+  ret = SetQueryTimeout(data);
+  
+  if (ret == SQL_ERROR) {
+    data->result = ret;
+    return;
+  }
 
   // SQLExecDirect will use bound parameters, but without the overhead of SQLPrepare
   // for a single execution.
@@ -890,11 +1380,11 @@ void ODBCConnection::UV_AfterQuery(uv_work_t* req, int status) {
     //this means we should release the handle now and call back
     //with NanTrue()
     
-    uv_mutex_lock(&ODBC::g_odbcMutex);
+    uv_mutex_t* locked = ODBC::LockDriver(data->conn->m_lock);
     
     SQLFreeHandle(SQL_HANDLE_STMT, data->hSTMT);
    
-    uv_mutex_unlock(&ODBC::g_odbcMutex);
+    ODBC::UnlockDriver(locked);
     
     Local<Value> args[2];
     args[0] = NanNew<Value>(NanNull());
@@ -903,15 +1393,16 @@ void ODBCConnection::UV_AfterQuery(uv_work_t* req, int status) {
     data->cb->Call(2, args);
   }
   else {
-    Local<Value> args[4];
+    Local<Value> args[5];
     bool* canFreeHandle = new bool(true);
     
     args[0] = NanNew<External>(data->conn->m_hENV);
     args[1] = NanNew<External>(data->conn->m_hDBC);
     args[2] = NanNew<External>(data->hSTMT);
     args[3] = NanNew<External>(canFreeHandle);
+    args[4] = NanNew<External>(data->conn->m_lock);
     
-    Local<Object> js_result = NanNew<Function>(ODBCResult::constructor)->NewInstance(4, args);
+    Local<Object> js_result = NanNew<Function>(ODBCResult::constructor)->NewInstance(5, args);
 
     // Check now to see if there was an error (as there may be further result sets)
     if (data->result == SQL_ERROR) {
@@ -933,21 +1424,7 @@ void ODBCConnection::UV_AfterQuery(uv_work_t* req, int status) {
   delete data->cb;
 
   if (data->paramCount) {
-    Parameter prm;
-    // free parameters
-    for (int i = 0; i < data->paramCount; i++) {
-      if (prm = data->params[i], prm.ParameterValuePtr != NULL) {
-        switch (prm.ValueType) {
-          case SQL_C_WCHAR:   free(prm.ParameterValuePtr);             break; 
-          case SQL_C_CHAR:    free(prm.ParameterValuePtr);             break; 
-          case SQL_C_LONG:    delete (int64_t *)prm.ParameterValuePtr; break;
-          case SQL_C_DOUBLE:  delete (double  *)prm.ParameterValuePtr; break;
-          case SQL_C_BIT:     delete (bool    *)prm.ParameterValuePtr; break;
-        }
-      }
-    }
-    
-    free(data->params);
+    ODBC::FreeParameters(data->params, data->paramCount);
   }
   
   free(data->sql);
@@ -962,65 +1439,728 @@ void ODBCConnection::UV_AfterQuery(uv_work_t* req, int status) {
 
 
 /*
- * QuerySync
+ * QueryAll
+ * 
+ * Execute a query, read every row of every result set and free the 
+ * statement in a single trip to the thread pool. Calls back with an array
+ * holding the rows of each result set.
  */
 
-NAN_METHOD(ODBCConnection::QuerySync) {
-  DEBUG_PRINTF("ODBCConnection::QuerySync\n");
+NAN_METHOD(ODBCConnection::QueryAll) {
+  DEBUG_PRINTF("ODBCConnection::QueryAll\n");
   NanScope();
-
-#ifdef UNICODE
-  String::Value* sql;
-#else
-  String::Utf8Value* sql;
-#endif
-
+  
+  Local<Function> cb;
+  
+  Local<String> sql;
+  
   ODBCConnection* conn = ObjectWrap::Unwrap<ODBCConnection>(args.Holder());
   
-  Parameter* params = new Parameter[0];
-  Parameter prm;
-  SQLRETURN ret;
-  HSTMT hSTMT;
-  int paramCount = 0;
-  bool noResultObject = false;
+  query_work_data* data = (query_work_data *) calloc(1, sizeof(query_work_data));
+  
+  data->fetchMode = FETCH_OBJECT;
+  data->fetchSize = QUERY_ALL_BLOCK_SIZE;
+  data->timeout = conn->queryTimeout;
   
   //Check arguments for different variations of calling this function
-  if (args.Length() == 2) {
-    //handle QuerySync("sql string", [params]);
+  if (args.Length() == 3) {
+    //handle QueryAll("sql string", [params], function cb () {});
     
     if ( !args[0]->IsString() ) {
-      return NanThrowTypeError("ODBCConnection::QuerySync(): Argument 0 must be an String.");
+      free(data);
+      return NanThrowTypeError("Argument 0 must be an String.");
     }
-    else if (!args[1]->IsArray()) {
-      return NanThrowTypeError("ODBCConnection::QuerySync(): Argument 1 must be an Array.");
+    else if ( !args[1]->IsArray() ) {
+      free(data);
+      return NanThrowTypeError("Argument 1 must be an Array.");
+    }
+    else if ( !args[2]->IsFunction() ) {
+      free(data);
+      return NanThrowTypeError("Argument 2 must be a Function.");
     }
 
-#ifdef UNICODE
-    sql = new String::Value(args[0]->ToString());
-#else
-    sql = new String::Utf8Value(args[0]->ToString());
-#endif
-
-    params = ODBC::GetParametersFromArray(
+    sql = args[0]->ToString();
+    
+    data->params = ODBC::GetParametersFromArray(
       Local<Array>::Cast(args[1]),
-      &paramCount);
-
+      &data->paramCount);
+    
+    cb = Local<Function>::Cast(args[2]);
   }
-  else if (args.Length() == 1 ) {
-    //handle either QuerySync("sql") or QuerySync({ settings })
-
-    if (args[0]->IsString()) {
-      //handle Query("sql")
-#ifdef UNICODE
-      sql = new String::Value(args[0]->ToString());
-#else
-      sql = new String::Utf8Value(args[0]->ToString());
-#endif
+  else if (args.Length() == 2 && args[1]->IsFunction() 
+           && (args[0]->IsString() || args[0]->IsObject())) {
+    //handle QueryAll("sql", cb) or QueryAll({ settings }, cb)
+    cb = Local<Function>::Cast(args[1]);
     
-      paramCount = 0;
-    }
-    else if (args[0]->IsObject()) {
-      //NOTE: going forward this is the way we should expand options
+    if (args[0]->IsString()) {
+      sql = args[0]->ToString();
+      
+      data->paramCount = 0;
+    }
+    else {
+      Local<Object> obj = args[0]->ToObject();
+      
+      Local<String> optionSqlKey = NanNew(OPTION_SQL);
+      if (obj->Has(optionSqlKey) && obj->Get(optionSqlKey)->IsString()) {
+        sql = obj->Get(optionSqlKey)->ToString();
+      }
+      else {
+        sql = NanNew("");
+      }
+      
+      Local<String> optionParamsKey = NanNew(OPTION_PARAMS);
+      if (obj->Has(optionParamsKey) && obj->Get(optionParamsKey)->IsArray()) {
+        data->params = ODBC::GetParametersFromArray(
+          Local<Array>::Cast(obj->Get(optionParamsKey)),
+          &data->paramCount);
+      }
+      else {
+        data->paramCount = 0;
+      }
+      
+      Local<String> fetchModeKey = NanNew(ODBCResult::OPTION_FETCH_MODE);
+      if (obj->Has(fetchModeKey) && obj->Get(fetchModeKey)->IsInt32()) {
+        data->fetchMode = obj->Get(fetchModeKey)->ToInt32()->Value();
+      }
+      
+      Local<String> fetchSizeKey = NanNew(ODBCResult::OPTION_FETCH_SIZE);
+      if (obj->Has(fetchSizeKey) && obj->Get(fetchSizeKey)->IsInt32()
+          && obj->Get(fetchSizeKey)->ToInt32()->Value() > 1) {
+        data->fetchSize = obj->Get(fetchSizeKey)->ToInt32()->Value();
+      }
+      
+      Local<String> optionTimeoutKey = NanNew(OPTION_TIMEOUT);
+      if (obj->Has(optionTimeoutKey) && obj->Get(optionTimeoutKey)->IsNumber()) {
+        data->timeout = obj->Get(optionTimeoutKey)->Uint32Value();
+      }
+    }
+  }
+  else {
+    free(data);
+    return NanThrowTypeError("ODBCConnection::QueryAll(): Requires either 2 or 3 Arguments. The last argument must be a Function.");
+  }
+  //Done checking arguments
+  
+  uv_work_t* work_req = (uv_work_t *) (calloc(1, sizeof(uv_work_t)));
+
+  data->cb = new NanCallback(cb);
+  data->sqlLen = sql->Length();
+
+#ifdef UNICODE
+  data->sqlSize = (data->sqlLen * sizeof(uint16_t)) + sizeof(uint16_t);
+  data->sql = (uint16_t *) malloc(data->sqlSize);
+  sql->Write((uint16_t *) data->sql);
+#else
+  data->sqlSize = sql->Utf8Length() + 1;
+  data->sql = (char *) malloc(data->sqlSize);
+  sql->WriteUtf8((char *) data->sql);
+#endif
+
+  DEBUG_PRINTF("ODBCConnection::QueryAll : sqlLen=%i, sqlSize=%i, sql=%s\n",
+               data->sqlLen, data->sqlSize, (char*) data->sql);
+  
+  //statements with parameters are prepared once and kept
+  if (data->paramCount > 0 && conn->m_statementCacheSize > 0) {
+    data->cached = conn->AcquireCachedStatement(data->sql, data->sqlSize);
+    
+    if (data->cached) {
+      data->hSTMT = data->cached->hSTMT;
+    }
+    else {
+      data->prepare = true;
+    }
+  }
+  
+  data->conn = conn;
+  work_req->data = data;
+  
+  if (!conn->asyncPolling 
+      || !conn->StartQueryAsync(work_req, (uv_after_work_cb)UV_AfterExecuteQueryAll)) {
+    ODBCWorkerPool::Queue(
+      conn->m_lock,
+      work_req, 
+      UV_QueryAll, 
+      (uv_after_work_cb)UV_AfterQueryAll);
+  }
+
+  conn->Ref();
+
+  NanReturnValue(NanUndefined());
+}
+
+void ODBCConnection::UV_QueryAll(uv_work_t* req) {
+  DEBUG_PRINTF("ODBCConnection::UV_QueryAll\n");
+  
+  query_work_data* data = (query_work_data *)(req->data);
+  
+  SQLRETURN ret;
+  
+  //with asyncPolling the statement has already been executed
+  if (!data->executed) {
+    if (!data->cached) {
+      uv_mutex_t* locked = ODBC::LockDriver(data->conn->m_lock);
+
+      //allocate a new statment handle
+      SQLAllocHandle( SQL_HANDLE_STMT, 
+                      data->conn->m_hDBC, 
+                      &data->hSTMT );
+
+      ODBC::UnlockDriver(locked);
+    }
+    
+    ret = SetQueryTimeout(data);
+    
+    if (ret != SQL_ERROR) {
+      ret = BindQueryParameters(data);
+    }
+    
+    if (ret != SQL_ERROR) {
+      ret = ExecuteQuery(data);
+    }
+    
+    data->result = ret;
+  }
+  
+  if (data->result == SQL_ERROR) {
+    return;
+  }
+  
+  //read every result set into blocks; they are turned into javascript 
+  //values in UV_AfterQueryAll
+  do {
+    data->sets = (query_all_set *) realloc(
+      data->sets, 
+      (data->setCount + 1) * sizeof(query_all_set));
+    
+    query_all_set* set = &data->sets[data->setCount++];
+    
+    set->columns = ODBC::DescribeColumns(data->hSTMT, &set->colCount);
+    set->blocks = NULL;
+    set->blockCount = 0;
+    
+    ret = SQL_NO_DATA;
+    
+    while (set->colCount > 0) {
+      RowBlock* block = ODBC::AllocRowBlock(
+        set->columns,
+        set->colCount,
+        data->fetchSize,
+        false);
+      
+      ret = ODBC::FetchRowBlock(data->hSTMT, set->columns, block);
+      
+      if (block->rowCount > 0) {
+        set->blocks = (RowBlock **) realloc(
+          set->blocks, 
+          (set->blockCount + 1) * sizeof(RowBlock *));
+        
+        set->blocks[set->blockCount++] = block;
+      }
+      else {
+        ODBC::FreeRowBlock(block);
+      }
+      
+      if (!SQL_SUCCEEDED(ret)) {
+        break;
+      }
+    }
+    
+    if (ret == SQL_ERROR) {
+      data->result = ret;
+      return;
+    }
+    
+    ret = SQLMoreResults(data->hSTMT);
+    
+    if (ret == SQL_ERROR) {
+      data->result = ret;
+      return;
+    }
+  } while (SQL_SUCCEEDED(ret));
+}
+
+void ODBCConnection::UV_AfterQueryAll(uv_work_t* req, int status) {
+  DEBUG_PRINTF("ODBCConnection::UV_AfterQueryAll\n");
+  
+  NanScope();
+  
+  query_work_data* data = (query_work_data *)(req->data);
+  
+  Local<Array> sets = NanNew<Array>();
+  Local<Value> args[2];
+  
+  for (int i = 0; i < data->setCount; i++) {
+    query_all_set* set = &data->sets[i];
+    
+    ODBC::CreateColumnKeys(set->columns, &set->colCount);
+    
+    if (set->colCount > 0 && data->fetchMode == FETCH_COLUMNS) {
+      ColumnVector* vectors = ODBC::AllocColumnVectors(set->colCount);
+      Local<Array> columnArrays = NanNew<Array>();
+      
+      for (int b = 0; b < set->blockCount; b++) {
+        ODBC::AppendColumnVectors(
+          set->columns,
+          &set->colCount,
+          set->blocks[b],
+          vectors,
+          columnArrays);
+      }
+      
+      sets->Set(i, ODBC::GetColumnVectors(
+        set->columns,
+        &set->colCount,
+        vectors,
+        columnArrays));
+      
+      ODBC::FreeColumnVectors(vectors, set->colCount);
+    }
+    else {
+      Local<Array> rows = NanNew<Array>();
+      Local<Object> recordTemplate = ODBC::GetRecordTemplate(
+        set->columns,
+        &set->colCount);
+      int count = 0;
+      
+      for (int b = 0; b < set->blockCount; b++) {
+        for (int row = 0; row < (int) set->blocks[b]->rowCount; row++) {
+          if (data->fetchMode == FETCH_ARRAY) {
+            rows->Set(
+              NanNew(count),
+              ODBC::GetBlockRecordArray(
+                set->columns,
+                &set->colCount,
+                set->blocks[b],
+                row));
+          }
+          else {
+            rows->Set(
+              NanNew(count),
+              ODBC::GetBlockRecordTuple(
+                set->columns,
+                &set->colCount,
+                set->blocks[b],
+                row,
+                recordTemplate));
+          }
+          
+          count++;
+        }
+      }
+      
+      sets->Set(i, rows);
+    }
+    
+    for (int b = 0; b < set->blockCount; b++) {
+      ODBC::FreeRowBlock(set->blocks[b]);
+    }
+    
+    free(set->blocks);
+    ODBC::FreeColumns(set->columns, &set->colCount);
+  }
+  
+  free(data->sets);
+  
+  if (data->result == SQL_ERROR) {
+    args[0] = ODBC::GetSQLError(
+      SQL_HANDLE_STMT,
+      data->hSTMT,
+      (char *) "[node-odbc] Error in ODBCConnection::UV_AfterQueryAll");
+  }
+  else {
+    args[0] = NanNew<Value>(NanNull());
+  }
+  
+  args[1] = sets;
+  
+  //a statement that failed is not kept, in case it is the statement that
+  //is no longer any good
+  if (data->cached) {
+    data->conn->ReleaseCachedStatement(data->cached, data->result != SQL_ERROR);
+  }
+  else if (data->prepare && data->result != SQL_ERROR) {
+    data->conn->CacheStatement(data->sql, data->sqlSize, data->hSTMT);
+  }
+  else {
+    uv_mutex_t* locked = ODBC::LockDriver(data->conn->m_lock);
+    
+    SQLFreeHandle(SQL_HANDLE_STMT, data->hSTMT);
+    
+    ODBC::UnlockDriver(locked);
+  }
+  
+  TryCatch try_catch;
+  
+  data->cb->Call(2, args);
+  
+  data->conn->Unref();
+  
+  if (try_catch.HasCaught()) {
+    FatalException(try_catch);
+  }
+  
+  delete data->cb;
+
+  if (data->paramCount) {
+    ODBC::FreeParameters(data->params, data->paramCount);
+  }
+  
+  free(data->sql);
+  free(data);
+  free(req);
+}
+
+/*
+ * UV_AfterExecuteQueryAll
+ * 
+ * A query run with asyncPolling has been executed on the main thread; read
+ * its results on the thread pool.
+ */
+
+void ODBCConnection::UV_AfterExecuteQueryAll(uv_work_t* req, int status) {
+  DEBUG_PRINTF("ODBCConnection::UV_AfterExecuteQueryAll\n");
+  
+  query_work_data* data = (query_work_data *)(req->data);
+  
+  data->executed = true;
+  
+  if (data->result == SQL_ERROR) {
+    UV_AfterQueryAll(req, status);
+    
+    return;
+  }
+  
+  ODBCWorkerPool::Queue(
+    data->conn->m_lock,
+    req, 
+    UV_QueryAll, 
+    (uv_after_work_cb)UV_AfterQueryAll);
+}
+
+/*
+ * StartQueryAsync
+ * 
+ * Execute a query from the main thread with SQL_ATTR_ASYNC_ENABLE on, 
+ * polling the driver until it has finished instead of waiting on the thread
+ * pool, then call after. Returns false, having done nothing, if the driver
+ * cannot execute the statement asynchronously or another thread holds the 
+ * lock needed to allocate it.
+ */
+
+bool ODBCConnection::StartQueryAsync(uv_work_t* req, uv_after_work_cb after) {
+  DEBUG_PRINTF("ODBCConnection::StartQueryAsync\n");
+  
+  query_work_data* data = (query_work_data *)(req->data);
+  
+  if (!data->cached) {
+    uv_mutex_t* locked;
+    
+    //the main thread must not wait for the lock; if a worker has it, let 
+    //the thread pool do the waiting instead
+    if (!ODBC::TryLockDriver(m_lock, &locked)) {
+      return false;
+    }
+    
+    SQLAllocHandle( SQL_HANDLE_STMT, 
+                    m_hDBC, 
+                    &data->hSTMT );
+    
+    if (!ODBC::EnableAsync(data->hSTMT)) {
+      SQLFreeHandle(SQL_HANDLE_STMT, data->hSTMT);
+      data->hSTMT = NULL;
+      
+      ODBC::UnlockDriver(locked);
+      
+      return false;
+    }
+    
+    ODBC::UnlockDriver(locked);
+  }
+  else if (!ODBC::EnableAsync(data->hSTMT)) {
+    return false;
+  }
+  
+  data->result = SetQueryTimeout(data);
+  
+  if (data->result != SQL_ERROR) {
+    data->result = BindQueryParameters(data);
+  }
+  
+  ODBC::PollAsync(req, data->hSTMT, ExecuteQueryAsync, after);
+  
+  return true;
+}
+
+/*
+ * SetQueryTimeout
+ * 
+ * Set SQL_ATTR_QUERY_TIMEOUT on the statement for a query. A cached 
+ * statement keeps the timeout of the query that last used it, so it is
+ * always set again.
+ */
+
+SQLRETURN ODBCConnection::SetQueryTimeout(query_work_data* data) {
+  if (data->timeout == 0 && !data->cached) {
+    return SQL_SUCCESS;
+  }
+  
+  DEBUG_PRINTF("ODBCConnection::SetQueryTimeout : timeout=%u\n", data->timeout);
+  
+  return SQLSetStmtAttr(
+    data->hSTMT,
+    SQL_ATTR_QUERY_TIMEOUT,
+    (SQLPOINTER) size_t(data->timeout),
+    0);
+}
+
+/*
+ * BindQueryParameters
+ */
+
+SQLRETURN ODBCConnection::BindQueryParameters(query_work_data* data) {
+  SQLRETURN ret = SQL_SUCCESS;
+  
+  for (int i = 0; i < data->paramCount; i++) {
+    Parameter prm = data->params[i];
+
+    ret = SQLBindParameter(
+      data->hSTMT,                        //StatementHandle
+      i + 1,                              //ParameterNumber
+      SQL_PARAM_INPUT,                    //InputOutputType
+      prm.ValueType,
+      prm.ParameterType,
+      prm.ColumnSize,
+      prm.DecimalDigits,
+      prm.ParameterValuePtr,
+      prm.BufferLength,
+      &data->params[i].StrLen_or_IndPtr);
+
+    if (ret == SQL_ERROR) {
+      break;
+    }
+  }
+  
+  return ret;
+}
+
+/*
+ * ExecuteQuery
+ * 
+ * Execute the statement for a query, preparing it first if it is going to
+ * be cached. When the statement is executing asynchronously this is called
+ * again, with the same arguments, until it stops returning 
+ * SQL_STILL_EXECUTING.
+ */
+
+SQLRETURN ODBCConnection::ExecuteQuery(query_work_data* data) {
+  SQLRETURN ret;
+  
+  if (data->prepare && !data->prepared) {
+    ret = SQLPrepare(
+      data->hSTMT,
+      (SQLTCHAR *)data->sql,
+      data->sqlLen);
+    
+    if (!SQL_SUCCEEDED(ret)) {
+      return ret;
+    }
+    
+    data->prepared = true;
+  }
+  
+  if (data->cached || data->prepare) {
+    return SQLExecute(data->hSTMT);
+  }
+  
+  return SQLExecDirect(
+    data->hSTMT,
+    (SQLTCHAR *)data->sql,
+    data->sqlLen);
+}
+
+SQLRETURN ODBCConnection::ExecuteQueryAsync(uv_work_t* req) {
+  query_work_data* data = (query_work_data *)(req->data);
+  
+  if (data->result != SQL_ERROR) {
+    data->result = ExecuteQuery(data);
+  }
+  
+  return data->result;
+}
+
+/*
+ * Statement cache
+ * 
+ * queryAll keeps the statements it prepares for queries with parameters,
+ * keyed by their SQL text, and executes them again instead of preparing
+ * the same SQL twice. When the cache is full the least recently used 
+ * statement that is not running is freed. These are only called on the 
+ * main thread, apart from Free.
+ */
+
+statement_cache_entry* ODBCConnection::AcquireCachedStatement(void* sql, int sqlSize) {
+  for (int i = 0; i < m_statementCacheCount; i++) {
+    statement_cache_entry* entry = m_statementCache[i];
+    
+    if (!entry->inUse && entry->sqlSize == sqlSize 
+        && memcmp(entry->sql, sql, sqlSize) == 0) {
+      entry->inUse = true;
+      m_statementCacheHits++;
+      
+      return entry;
+    }
+  }
+  
+  m_statementCacheMisses++;
+  
+  return NULL;
+}
+
+void ODBCConnection::ReleaseCachedStatement(statement_cache_entry* entry, bool keep) {
+  if (keep) {
+    entry->inUse = false;
+    entry->lastUsed = ++m_statementCacheClock;
+    
+    uv_mutex_t* locked = ODBC::LockDriver(m_lock);
+    SQLFreeStmt(entry->hSTMT, SQL_CLOSE);
+    SQLFreeStmt(entry->hSTMT, SQL_RESET_PARAMS);
+    ODBC::UnlockDriver(locked);
+    
+    TrimStatementCache();
+    
+    return;
+  }
+  
+  for (int i = 0; i < m_statementCacheCount; i++) {
+    if (m_statementCache[i] == entry) {
+      FreeCachedStatement(i);
+      
+      return;
+    }
+  }
+}
+
+void ODBCConnection::CacheStatement(void* sql, int sqlSize, HSTMT hSTMT) {
+  uv_mutex_t* locked = ODBC::LockDriver(m_lock);
+  SQLFreeStmt(hSTMT, SQL_CLOSE);
+  SQLFreeStmt(hSTMT, SQL_RESET_PARAMS);
+  ODBC::UnlockDriver(locked);
+  
+  statement_cache_entry* entry = 
+    (statement_cache_entry *) malloc(sizeof(statement_cache_entry));
+  
+  entry->sql = malloc(sqlSize);
+  memcpy(entry->sql, sql, sqlSize);
+  entry->sqlSize = sqlSize;
+  entry->hSTMT = hSTMT;
+  entry->lastUsed = ++m_statementCacheClock;
+  entry->inUse = false;
+  
+  m_statementCache = (statement_cache_entry **) realloc(
+    m_statementCache,
+    (m_statementCacheCount + 1) * sizeof(statement_cache_entry *));
+  
+  m_statementCache[m_statementCacheCount++] = entry;
+  
+  TrimStatementCache();
+}
+
+void ODBCConnection::TrimStatementCache() {
+  while (m_statementCacheCount > m_statementCacheSize) {
+    int oldest = -1;
+    
+    for (int i = 0; i < m_statementCacheCount; i++) {
+      if (!m_statementCache[i]->inUse && (oldest == -1 
+          || m_statementCache[i]->lastUsed < m_statementCache[oldest]->lastUsed)) {
+        oldest = i;
+      }
+    }
+    
+    if (oldest == -1) {
+      //everything is running; try again when something is released
+      return;
+    }
+    
+    FreeCachedStatement(oldest);
+  }
+}
+
+void ODBCConnection::FreeCachedStatement(int index) {
+  statement_cache_entry* entry = m_statementCache[index];
+  
+  DEBUG_PRINTF("ODBCConnection::FreeCachedStatement hSTMT=%X\n", entry->hSTMT);
+  
+  uv_mutex_t* locked = ODBC::LockDriver(m_lock);
+  SQLFreeHandle(SQL_HANDLE_STMT, entry->hSTMT);
+  ODBC::UnlockDriver(locked);
+  
+  free(entry->sql);
+  free(entry);
+  
+  m_statementCache[index] = m_statementCache[--m_statementCacheCount];
+}
+
+/*
+ * QuerySync
+ */
+
+NAN_METHOD(ODBCConnection::QuerySync) {
+  DEBUG_PRINTF("ODBCConnection::QuerySync\n");
+  NanScope();
+
+#ifdef UNICODE
+  String::Value* sql;
+#else
+  String::Utf8Value* sql;
+#endif
+
+  ODBCConnection* conn = ObjectWrap::Unwrap<ODBCConnection>(args.Holder());
+  
+  Parameter* params = NULL;
+  Parameter prm;
+  SQLRETURN ret;
+  HSTMT hSTMT;
+  int paramCount = 0;
+  bool noResultObject = false;
+  SQLUINTEGER timeout = conn->queryTimeout;
+  
+  //Check arguments for different variations of calling this function
+  if (args.Length() == 2) {
+    //handle QuerySync("sql string", [params]);
+    
+    if ( !args[0]->IsString() ) {
+      return NanThrowTypeError("ODBCConnection::QuerySync(): Argument 0 must be an String.");
+    }
+    else if (!args[1]->IsArray()) {
+      return NanThrowTypeError("ODBCConnection::QuerySync(): Argument 1 must be an Array.");
+    }
+
+#ifdef UNICODE
+    sql = new String::Value(args[0]->ToString());
+#else
+    sql = new String::Utf8Value(args[0]->ToString());
+#endif
+
+    params = ODBC::GetParametersFromArray(
+      Local<Array>::Cast(args[1]),
+      &paramCount);
+
+  }
+  else if (args.Length() == 1 ) {
+    //handle either QuerySync("sql") or QuerySync({ settings })
+
+    if (args[0]->IsString()) {
+      //handle Query("sql")
+#ifdef UNICODE
+      sql = new String::Value(args[0]->ToString());
+#else
+      sql = new String::Utf8Value(args[0]->ToString());
+#endif
+    
+      paramCount = 0;
+    }
+    else if (args[0]->IsObject()) {
+      //NOTE: going forward this is the way we should expand options
       //rather than adding more arguments to the function signature.
       //specify options on an options object.
       //handle Query({}, function cb () {});
@@ -1057,6 +2197,11 @@ NAN_METHOD(ODBCConnection::QuerySync) {
       if (obj->Has(optionNoResultsKey) && obj->Get(optionNoResultsKey)->IsBoolean()) {
         noResultObject = obj->Get(optionNoResultsKey)->ToBoolean()->Value();
       }
+      
+      Local<String> optionTimeoutKey = NanNew(OPTION_TIMEOUT);
+      if (obj->Has(optionTimeoutKey) && obj->Get(optionTimeoutKey)->IsNumber()) {
+        timeout = obj->Get(optionTimeoutKey)->Uint32Value();
+      }
     }
     else {
       return NanThrowTypeError("ODBCConnection::QuerySync(): Argument 0 must be a String or an Object.");
@@ -1067,19 +2212,27 @@ NAN_METHOD(ODBCConnection::QuerySync) {
   }
   //Done checking arguments
 
-  uv_mutex_lock(&ODBC::g_odbcMutex);
+  uv_mutex_t* locked = ODBC::LockDriver(conn->m_lock);
 
   //allocate a new statment handle
   ret = SQLAllocHandle( SQL_HANDLE_STMT, 
                   conn->m_hDBC, 
                   &hSTMT );
 
-  uv_mutex_unlock(&ODBC::g_odbcMutex);
+  ODBC::UnlockDriver(locked);
 
   DEBUG_PRINTF("ODBCConnection::QuerySync - hSTMT=%p\n", hSTMT);
   
   if (SQL_SUCCEEDED(ret)) {
-    if (paramCount) {
+    if (timeout > 0) {
+      ret = SQLSetStmtAttr(
+        hSTMT,
+        SQL_ATTR_QUERY_TIMEOUT,
+        (SQLPOINTER) size_t(timeout),
+        0);
+    }
+    
+    if (SQL_SUCCEEDED(ret) && paramCount) {
       for (int i = 0; i < paramCount; i++) {
         prm = params[i];
         
@@ -1110,20 +2263,7 @@ NAN_METHOD(ODBCConnection::QuerySync) {
         sql->length());
     }
     
-    // free parameters
-    for (int i = 0; i < paramCount; i++) {
-      if (prm = params[i], prm.ParameterValuePtr != NULL) {
-        switch (prm.ValueType) {
-          case SQL_C_WCHAR:   free(prm.ParameterValuePtr);             break;
-          case SQL_C_CHAR:    free(prm.ParameterValuePtr);             break; 
-          case SQL_C_LONG:    delete (int64_t *)prm.ParameterValuePtr; break;
-          case SQL_C_DOUBLE:  delete (double  *)prm.ParameterValuePtr; break;
-          case SQL_C_BIT:     delete (bool    *)prm.ParameterValuePtr; break;
-        }
-      }
-    }
-    
-    free(params);
+    ODBC::FreeParameters(params, paramCount);
   }
   
   delete sql;
@@ -1141,24 +2281,25 @@ NAN_METHOD(ODBCConnection::QuerySync) {
   else if (noResultObject) {
     //if there is not result object requested then
     //we must destroy the STMT ourselves.
-    uv_mutex_lock(&ODBC::g_odbcMutex);
+    locked = ODBC::LockDriver(conn->m_lock);
     
     SQLFreeHandle(SQL_HANDLE_STMT, hSTMT);
    
-    uv_mutex_unlock(&ODBC::g_odbcMutex);
+    ODBC::UnlockDriver(locked);
     
     NanReturnValue(NanTrue());
   }
   else {
-    Local<Value> result[4];
+    Local<Value> result[5];
     bool* canFreeHandle = new bool(true);
     
     result[0] = NanNew<External>(conn->m_hENV);
     result[1] = NanNew<External>(conn->m_hDBC);
     result[2] = NanNew<External>(hSTMT);
     result[3] = NanNew<External>(canFreeHandle);
+    result[4] = NanNew<External>(conn->m_lock);
     
-    Local<Object> js_result = NanNew<Function>(ODBCResult::constructor)->NewInstance(4, result);
+    Local<Object> js_result = NanNew<Function>(ODBCResult::constructor)->NewInstance(5, result);
 
     NanReturnValue(js_result);
   }
@@ -1241,8 +2382,8 @@ NAN_METHOD(ODBCConnection::Tables) {
   data->conn = conn;
   work_req->data = data;
   
-  uv_queue_work(
-    uv_default_loop(), 
+  ODBCWorkerPool::Queue(
+    conn->m_lock, 
     work_req, 
     UV_Tables, 
     (uv_after_work_cb) UV_AfterQuery);
@@ -1255,11 +2396,11 @@ NAN_METHOD(ODBCConnection::Tables) {
 void ODBCConnection::UV_Tables(uv_work_t* req) {
   query_work_data* data = (query_work_data *)(req->data);
   
-  uv_mutex_lock(&ODBC::g_odbcMutex);
+  uv_mutex_t* locked = ODBC::LockDriver(data->conn->m_lock);
   
   SQLAllocHandle(SQL_HANDLE_STMT, data->conn->m_hDBC, &data->hSTMT );
   
-  uv_mutex_unlock(&ODBC::g_odbcMutex);
+  ODBC::UnlockDriver(locked);
   
   SQLRETURN ret = SQLTables( 
     data->hSTMT, 
@@ -1352,8 +2493,8 @@ NAN_METHOD(ODBCConnection::Columns) {
   data->conn = conn;
   work_req->data = data;
   
-  uv_queue_work(
-    uv_default_loop(),
+  ODBCWorkerPool::Queue(
+    conn->m_lock,
     work_req, 
     UV_Columns, 
     (uv_after_work_cb)UV_AfterQuery);
@@ -1366,11 +2507,11 @@ NAN_METHOD(ODBCConnection::Columns) {
 void ODBCConnection::UV_Columns(uv_work_t* req) {
   query_work_data* data = (query_work_data *)(req->data);
   
-  uv_mutex_lock(&ODBC::g_odbcMutex);
+  uv_mutex_t* locked = ODBC::LockDriver(data->conn->m_lock);
   
   SQLAllocHandle(SQL_HANDLE_STMT, data->conn->m_hDBC, &data->hSTMT );
   
-  uv_mutex_unlock(&ODBC::g_odbcMutex);
+  ODBC::UnlockDriver(locked);
   
   SQLRETURN ret = SQLColumns( 
     data->hSTMT, 
@@ -1442,8 +2583,8 @@ NAN_METHOD(ODBCConnection::BeginTransaction) {
   data->conn = conn;
   work_req->data = data;
   
-  uv_queue_work(
-    uv_default_loop(),
+  ODBCWorkerPool::Queue(
+    conn->m_lock,
     work_req, 
     UV_BeginTransaction, 
     (uv_after_work_cb)UV_AfterBeginTransaction);
@@ -1602,8 +2743,8 @@ NAN_METHOD(ODBCConnection::EndTransaction) {
   data->conn = conn;
   work_req->data = data;
   
-  uv_queue_work(
-    uv_default_loop(),
+  ODBCWorkerPool::Queue(
+    conn->m_lock,
     work_req, 
     UV_EndTransaction, 
     (uv_after_work_cb)UV_AfterEndTransaction);
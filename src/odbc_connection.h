@@ -20,11 +20,24 @@
 
 #include <nan.h>
 
+struct query_work_data;
+
+//a statement prepared by queryAll, kept so that running the same SQL again
+//does not have to prepare it again
+struct statement_cache_entry {
+  void *sql;
+  int sqlSize;
+  HSTMT hSTMT;
+  unsigned int lastUsed;
+  bool inUse;
+};
+
 class ODBCConnection : public node::ObjectWrap {
   public:
    static Persistent<String> OPTION_SQL;
    static Persistent<String> OPTION_PARAMS;
    static Persistent<String> OPTION_NORESULTS;
+   static Persistent<String> OPTION_TIMEOUT;
    static Persistent<Function> constructor;
    
    static void Init(v8::Handle<Object> exports);
@@ -50,6 +63,20 @@ class ODBCConnection : public node::ObjectWrap {
     static NAN_SETTER(ConnectTimeoutSetter);
     static NAN_GETTER(LoginTimeoutGetter);
     static NAN_SETTER(LoginTimeoutSetter);
+    static NAN_GETTER(StatementCacheSizeGetter);
+    static NAN_SETTER(StatementCacheSizeSetter);
+    static NAN_GETTER(StatementCacheHitsGetter);
+    static NAN_GETTER(StatementCacheMissesGetter);
+    static NAN_GETTER(AsyncPollingGetter);
+    static NAN_SETTER(AsyncPollingSetter);
+    static NAN_GETTER(QueryTimeoutGetter);
+    static NAN_SETTER(QueryTimeoutSetter);
+    static NAN_GETTER(LockModeGetter);
+    static NAN_SETTER(LockModeSetter);
+    static NAN_GETTER(LockAcquisitionsGetter);
+    static NAN_GETTER(LockContentionsGetter);
+    static NAN_GETTER(PinnedWorkerGetter);
+    static NAN_SETTER(PinnedWorkerSetter);
 
     //async methods
     static NAN_METHOD(BeginTransaction);
@@ -69,6 +96,11 @@ class ODBCConnection : public node::ObjectWrap {
     static void UV_Close(uv_work_t* work_req);
     static void UV_AfterClose(uv_work_t* work_req, int status);
 
+    static NAN_METHOD(Reset);
+    static NAN_METHOD(Validate);
+    static void UV_Reset(uv_work_t* work_req);
+    static void UV_AfterReset(uv_work_t* work_req, int status);
+
     static NAN_METHOD(CreateStatement);
     static void UV_CreateStatement(uv_work_t* work_req);
     static void UV_AfterCreateStatement(uv_work_t* work_req, int status);
@@ -77,6 +109,11 @@ class ODBCConnection : public node::ObjectWrap {
     static void UV_Query(uv_work_t* req);
     static void UV_AfterQuery(uv_work_t* req, int status);
 
+    static NAN_METHOD(QueryAll);
+    static void UV_QueryAll(uv_work_t* req);
+    static void UV_AfterQueryAll(uv_work_t* req, int status);
+    static void UV_AfterExecuteQueryAll(uv_work_t* req, int status);
+
     static NAN_METHOD(Columns);
     static void UV_Columns(uv_work_t* req);
     
@@ -85,6 +122,8 @@ class ODBCConnection : public node::ObjectWrap {
     
     //sync methods
     static NAN_METHOD(CloseSync);
+    static NAN_METHOD(ResetSync);
+    static NAN_METHOD(ValidateSync);
     static NAN_METHOD(CreateStatementSync);
     static NAN_METHOD(OpenSync);
     static NAN_METHOD(QuerySync);
@@ -97,16 +136,41 @@ class ODBCConnection : public node::ObjectWrap {
       SQLRETURN result;
     };
     
+    statement_cache_entry* AcquireCachedStatement(void* sql, int sqlSize);
+    void ReleaseCachedStatement(statement_cache_entry* entry, bool keep);
+    void CacheStatement(void* sql, int sqlSize, HSTMT hSTMT);
+    void TrimStatementCache();
+    void FreeCachedStatement(int index);
+    
+    SQLRETURN ResetConnection();
+    bool IsAlive();
+    
+    bool StartQueryAsync(uv_work_t* req, uv_after_work_cb after);
+    static SQLRETURN BindQueryParameters(query_work_data* data);
+    static SQLRETURN SetQueryTimeout(query_work_data* data);
+    static SQLRETURN ExecuteQuery(query_work_data* data);
+    static SQLRETURN ExecuteQueryAsync(uv_work_t* req);
+    
     ODBCConnection *self(void) { return this; }
 
   protected:
     HENV m_hENV;
     HDBC m_hDBC;
+    DriverLock *m_lock;
     SQLUSMALLINT canHaveMoreResults;
     bool connected;
     int statements;
     SQLUINTEGER connectTimeout;
     SQLUINTEGER loginTimeout;
+    bool asyncPolling;
+    SQLUINTEGER queryTimeout;
+    
+    statement_cache_entry **m_statementCache;
+    int m_statementCacheCount;
+    int m_statementCacheSize;
+    unsigned int m_statementCacheClock;
+    unsigned int m_statementCacheHits;
+    unsigned int m_statementCacheMisses;
 };
 
 struct create_statement_work_data {
@@ -116,6 +180,15 @@ struct create_statement_work_data {
   int result;
 };
 
+//one result set read by queryAll, held in blocks until it can be turned
+//into javascript values on the main thread
+struct query_all_set {
+  Column *columns;
+  short colCount;
+  RowBlock **blocks;
+  int blockCount;
+};
+
 struct query_work_data {
   NanCallback* cb;
   ODBCConnection *conn;
@@ -125,6 +198,7 @@ struct query_work_data {
   int paramCount;
   int completionType;
   bool noResultObject;
+  SQLUINTEGER timeout;
   
   void *sql;
   void *catalog;
@@ -136,6 +210,16 @@ struct query_work_data {
   int sqlLen;
   int sqlSize;
   
+  statement_cache_entry *cached;
+  bool prepare;
+  bool prepared;
+  bool executed;
+  
+  int fetchMode;
+  int fetchSize;
+  query_all_set *sets;
+  int setCount;
+  
   int result;
 };
 
@@ -153,4 +237,12 @@ struct close_connection_work_data {
   int result;
 };
 
+struct reset_connection_work_data {
+  NanCallback* cb;
+  ODBCConnection *conn;
+  bool validate;
+  bool alive;
+  int result;
+};
+
 #endif
@@ -25,12 +25,14 @@
 #include "odbc_connection.h"
 #include "odbc_result.h"
 #include "odbc_statement.h"
+#include "odbc_worker_pool.h"
 
 using namespace v8;
 using namespace node;
 
 Persistent<Function> ODBCResult::constructor;
 Persistent<String> ODBCResult::OPTION_FETCH_MODE;
+Persistent<String> ODBCResult::OPTION_FETCH_SIZE;
 
 void ODBCResult::Init(v8::Handle<Object> exports) {
   DEBUG_PRINTF("ODBCResult::Init\n");
@@ -48,16 +50,21 @@ void ODBCResult::Init(v8::Handle<Object> exports) {
   // Prototype Methods  
   NODE_SET_PROTOTYPE_METHOD(constructor_template, "fetchAll", FetchAll);
   NODE_SET_PROTOTYPE_METHOD(constructor_template, "fetch", Fetch);
+  NODE_SET_PROTOTYPE_METHOD(constructor_template, "fetchBatch", FetchBatch);
+  NODE_SET_PROTOTYPE_METHOD(constructor_template, "fetchEach", FetchEach);
 
   NODE_SET_PROTOTYPE_METHOD(constructor_template, "moreResultsSync", MoreResultsSync);
   NODE_SET_PROTOTYPE_METHOD(constructor_template, "closeSync", CloseSync);
   NODE_SET_PROTOTYPE_METHOD(constructor_template, "fetchSync", FetchSync);
   NODE_SET_PROTOTYPE_METHOD(constructor_template, "fetchAllSync", FetchAllSync);
   NODE_SET_PROTOTYPE_METHOD(constructor_template, "getColumnNamesSync", GetColumnNamesSync);
+  NODE_SET_PROTOTYPE_METHOD(constructor_template, "cancel", Cancel);
 
   // Properties
   NanAssignPersistent(OPTION_FETCH_MODE, NanNew("fetchMode"));
   instance_template->SetAccessor(NanNew("fetchMode"), FetchModeGetter, FetchModeSetter);
+  NanAssignPersistent(OPTION_FETCH_SIZE, NanNew("fetchSize"));
+  instance_template->SetAccessor(NanNew("fetchSize"), FetchSizeGetter, FetchSizeSetter);
   
   // Attach the Database Constructor to the target object
   NanAssignPersistent(constructor, constructor_template->GetFunction());
@@ -68,19 +75,37 @@ void ODBCResult::Init(v8::Handle<Object> exports) {
 ODBCResult::~ODBCResult() {
   DEBUG_PRINTF("ODBCResult::~ODBCResult m_hSTMT=%x\n", m_hSTMT);
   this->Free();
+  
+  ODBC::ReleaseDriverLock(m_lock);
 }
 
 void ODBCResult::Free() {
   DEBUG_PRINTF("ODBCResult::Free m_hSTMT=%X m_canFreeHandle=%X\n", m_hSTMT, m_canFreeHandle);
   
+  //a fetchBatch read-ahead is in SQLFetch on m_hSTMT; stop it and leave 
+  //freeing the handle to UV_AfterFetchBatch
+  if (m_batch && m_batch->fetching) {
+    m_batch->closing = true;
+    m_batch->closeOption = SQL_DESTROY;
+    
+    SQLCancel(m_hSTMT);
+    
+    return;
+  }
+  
+  //release anything left over from a fetchBatch that was not read to the end
+  if (m_batch) {
+    FreeFetchBatch(this);
+  }
+  
   if (m_hSTMT && m_canFreeHandle) {
-    uv_mutex_lock(&ODBC::g_odbcMutex);
+    uv_mutex_t* locked = ODBC::LockDriver(m_lock);
     
     SQLFreeHandle( SQL_HANDLE_STMT, m_hSTMT);
     
     m_hSTMT = NULL;
   
-    uv_mutex_unlock(&ODBC::g_odbcMutex);
+    ODBC::UnlockDriver(locked);
   }
   
   if (bufferLength > 0) {
@@ -97,6 +122,7 @@ NAN_METHOD(ODBCResult::New) {
   REQ_EXT_ARG(1, js_hdbc);
   REQ_EXT_ARG(2, js_hstmt);
   REQ_EXT_ARG(3, js_canFreeHandle);
+  REQ_EXT_ARG(4, js_lock);
   
   HENV hENV = static_cast<HENV>(js_henv->Value());
   HDBC hDBC = static_cast<HDBC>(js_hdbc->Value());
@@ -115,6 +141,10 @@ NAN_METHOD(ODBCResult::New) {
   
   //free the pointer to canFreeHandle
   delete canFreeHandle;
+  
+  //share the connection's lock
+  objODBCResult->m_lock = static_cast<DriverLock *>(js_lock->Value());
+  ODBC::RetainDriverLock(objODBCResult->m_lock);
 
   //specify the buffer length
   objODBCResult->bufferLength = MAX_VALUE_SIZE - 1;
@@ -125,10 +155,20 @@ NAN_METHOD(ODBCResult::New) {
 
   //set the initial colCount to 0
   objODBCResult->colCount = 0;
+  objODBCResult->recordTemplate = NULL;
+  
+  //no fetchBatch in progress
+  objODBCResult->m_batch = NULL;
+  
+  objODBCResult->m_fetching = false;
+  objODBCResult->m_canceled = false;
 
   //default fetchMode to FETCH_OBJECT
   objODBCResult->m_fetchMode = FETCH_OBJECT;
   
+  //default to fetching one row at a time
+  objODBCResult->m_fetchSize = DEFAULT_FETCH_SIZE;
+  
   objODBCResult->Wrap(args.Holder());
   
   NanReturnValue(args.Holder());
@@ -152,6 +192,24 @@ NAN_SETTER(ODBCResult::FetchModeSetter) {
   }
 }
 
+NAN_GETTER(ODBCResult::FetchSizeGetter) {
+  NanScope();
+
+  ODBCResult *obj = ObjectWrap::Unwrap<ODBCResult>(args.Holder());
+
+  NanReturnValue(NanNew(obj->m_fetchSize));
+}
+
+NAN_SETTER(ODBCResult::FetchSizeSetter) {
+  NanScope();
+
+  ODBCResult *obj = ObjectWrap::Unwrap<ODBCResult>(args.Holder());
+  
+  if (value->IsNumber() && value->Int32Value() > 0) {
+    obj->m_fetchSize = value->Int32Value();
+  }
+}
+
 /*
  * Fetch
  */
@@ -191,10 +249,30 @@ NAN_METHOD(ODBCResult::Fetch) {
   data->cb = new NanCallback(cb);
   
   data->objResult = objODBCResult;
+  
+  //the column descriptions are needed so the worker knows how to copy the
+  //row out of the driver
+  if (objODBCResult->colCount == 0) {
+    objODBCResult->columns = ODBC::GetColumns(
+      objODBCResult->m_hSTMT, 
+      &objODBCResult->colCount);
+  }
+  
+  if (objODBCResult->colCount > 0) {
+    data->block = ODBC::AllocRowBlock(
+      objODBCResult->columns,
+      objODBCResult->colCount,
+      1,
+      false);
+  }
+  
   work_req->data = data;
   
-  uv_queue_work(
-    uv_default_loop(), 
+  objODBCResult->m_fetching = true;
+  objODBCResult->m_canceled = false;
+  
+  ODBCWorkerPool::Queue(
+    objODBCResult->m_lock, 
     work_req, 
     UV_Fetch, 
     (uv_after_work_cb)UV_AfterFetch);
@@ -209,7 +287,15 @@ void ODBCResult::UV_Fetch(uv_work_t* work_req) {
   
   fetch_work_data* data = (fetch_work_data *)(work_req->data);
   
-  data->result = SQLFetch(data->objResult->m_hSTMT);
+  if (data->block) {
+    data->result = ODBC::FetchRowBlock(
+      data->objResult->m_hSTMT,
+      data->objResult->columns,
+      data->block);
+  }
+  else {
+    data->result = SQL_NO_DATA;
+  }
 }
 
 void ODBCResult::UV_AfterFetch(uv_work_t* work_req, int status) {
@@ -225,12 +311,6 @@ void ODBCResult::UV_AfterFetch(uv_work_t* work_req, int status) {
   bool moreWork = true;
   bool error = false;
   
-  if (data->objResult->colCount == 0) {
-    data->objResult->columns = ODBC::GetColumns(
-      data->objResult->m_hSTMT, 
-      &data->objResult->colCount);
-  }
-  
   //check to see if the result has no columns
   if (data->objResult->colCount == 0) {
     //this means
@@ -246,30 +326,40 @@ void ODBCResult::UV_AfterFetch(uv_work_t* work_req, int status) {
       data->objResult->m_hSTMT,
       (char *) "Error in ODBCResult::UV_AfterFetch");
   }
+  //canceled after the driver had already finished
+  else if (data->objResult->m_canceled) {
+    moreWork = false;
+    error = true;
+    
+    objError = GetCanceledError(
+      (char *) "[node-odbc] Operation canceled in ODBCResult::UV_AfterFetch");
+  }
   //check to see if we are at the end of the recordset
   else if (ret == SQL_NO_DATA) {
     moreWork = false;
   }
+  
+  data->objResult->m_fetching = false;
+  data->objResult->m_canceled = false;
 
   if (moreWork) {
     Handle<Value> args[2];
 
     args[0] = NanNull();
     if (data->fetchMode == FETCH_ARRAY) {
-      args[1] = ODBC::GetRecordArray(
-        data->objResult->m_hSTMT,
+      args[1] = ODBC::GetBlockRecordArray(
         data->objResult->columns,
         &data->objResult->colCount,
-        data->objResult->buffer,
-        data->objResult->bufferLength);
+        data->block,
+        0);
     }
     else {
-      args[1] = ODBC::GetRecordTuple(
-        data->objResult->m_hSTMT,
+      args[1] = ODBC::GetBlockRecordTuple(
         data->objResult->columns,
         &data->objResult->colCount,
-        data->objResult->buffer,
-        data->objResult->bufferLength);
+        data->block,
+        0,
+        data->objResult->GetRecordTemplate());
     }
 
     TryCatch try_catch;
@@ -282,7 +372,7 @@ void ODBCResult::UV_AfterFetch(uv_work_t* work_req, int status) {
     }
   }
   else {
-    ODBC::FreeColumns(data->objResult->columns, &data->objResult->colCount);
+    data->objResult->FreeColumns();
     
     Handle<Value> args[2];
     
@@ -308,6 +398,7 @@ void ODBCResult::UV_AfterFetch(uv_work_t* work_req, int status) {
   
   data->objResult->Unref();
   
+  ODBC::FreeRowBlock(data->block);
   free(data);
   free(work_req);
   
@@ -382,13 +473,14 @@ NAN_METHOD(ODBCResult::FetchSync) {
         objResult->columns,
         &objResult->colCount,
         objResult->buffer,
-        objResult->bufferLength);
+        objResult->bufferLength,
+        objResult->GetRecordTemplate());
     }
     
     NanReturnValue(data);
   }
   else {
-    ODBC::FreeColumns(objResult->columns, &objResult->colCount);
+    objResult->FreeColumns();
 
     //if there was an error, pass that as arg[0] otherwise Null
     if (error) {
@@ -412,13 +504,12 @@ NAN_METHOD(ODBCResult::FetchAll) {
   
   ODBCResult* objODBCResult = ObjectWrap::Unwrap<ODBCResult>(args.Holder());
   
-  uv_work_t* work_req = (uv_work_t *) (calloc(1, sizeof(uv_work_t)));
-  
   fetch_work_data* data = (fetch_work_data *) calloc(1, sizeof(fetch_work_data));
   
   Local<Function> cb;
   
   data->fetchMode = objODBCResult->m_fetchMode;
+  data->fetchSize = objODBCResult->m_fetchSize;
   
   if (args.Length() == 1 && args[0]->IsFunction()) {
     cb = Local<Function>::Cast(args[0]);
@@ -432,29 +523,173 @@ NAN_METHOD(ODBCResult::FetchAll) {
     if (obj->Has(fetchModeKey) && obj->Get(fetchModeKey)->IsInt32()) {
       data->fetchMode = obj->Get(fetchModeKey)->ToInt32()->Value();
     }
+    
+    Local<String> fetchSizeKey = NanNew<String>(OPTION_FETCH_SIZE);
+    if (obj->Has(fetchSizeKey) && obj->Get(fetchSizeKey)->IsInt32()
+        && obj->Get(fetchSizeKey)->ToInt32()->Value() > 0) {
+      data->fetchSize = obj->Get(fetchSizeKey)->ToInt32()->Value();
+    }
   }
   else {
     NanThrowTypeError("ODBCResult::FetchAll(): 1 or 2 arguments are required. The last argument must be a callback function.");
   }
   
+  data->mode = MODE_COLLECT_AND_CALLBACK;
+  data->cb = new NanCallback(cb);
+  data->each = NULL;
+  
+  StartFetchAll(objODBCResult, data);
+
+  NanReturnValue(NanUndefined());
+}
+
+/*
+ * FetchEach
+ * 
+ * Like fetchAll, but each batch of up to fetchSize rows is passed to 
+ * eachCallback as soon as it has been fetched and is not kept. Returning 
+ * false from eachCallback stops the fetch. The last callback gets the
+ * number of rows that were fetched.
+ */
+
+NAN_METHOD(ODBCResult::FetchEach) {
+  DEBUG_PRINTF("ODBCResult::FetchEach\n");
+  NanScope();
+  
+  ODBCResult* objODBCResult = ObjectWrap::Unwrap<ODBCResult>(args.Holder());
+  
+  Local<Function> each;
+  Local<Function> cb;
+  
+  int fetchMode = objODBCResult->m_fetchMode;
+  int fetchSize = objODBCResult->m_fetchSize;
+  
+  if (args.Length() == 2 && args[0]->IsFunction() && args[1]->IsFunction()) {
+    each = Local<Function>::Cast(args[0]);
+    cb = Local<Function>::Cast(args[1]);
+  }
+  else if (args.Length() == 3 && args[0]->IsObject() 
+           && args[1]->IsFunction() && args[2]->IsFunction()) {
+    each = Local<Function>::Cast(args[1]);
+    cb = Local<Function>::Cast(args[2]);
+    
+    Local<Object> obj = args[0]->ToObject();
+    
+    Local<String> fetchModeKey = NanNew<String>(OPTION_FETCH_MODE);
+    if (obj->Has(fetchModeKey) && obj->Get(fetchModeKey)->IsInt32()) {
+      fetchMode = obj->Get(fetchModeKey)->ToInt32()->Value();
+    }
+    
+    Local<String> fetchSizeKey = NanNew<String>(OPTION_FETCH_SIZE);
+    if (obj->Has(fetchSizeKey) && obj->Get(fetchSizeKey)->IsInt32()
+        && obj->Get(fetchSizeKey)->ToInt32()->Value() > 0) {
+      fetchSize = obj->Get(fetchSizeKey)->ToInt32()->Value();
+    }
+  }
+  else {
+    return NanThrowTypeError("ODBCResult::FetchEach(): 2 or 3 arguments are required. The last two arguments must be callback functions.");
+  }
+  
+  fetch_work_data* data = (fetch_work_data *) calloc(1, sizeof(fetch_work_data));
+  
+  data->fetchMode = fetchMode;
+  data->fetchSize = fetchSize;
+  data->mode = MODE_CALLBACK_FOR_EACH;
+  data->cb = new NanCallback(cb);
+  data->each = new NanCallback(each);
+  
+  StartFetchAll(objODBCResult, data);
+  
+  NanReturnValue(NanUndefined());
+}
+
+/*
+ * StartFetchAll
+ * 
+ * Set up the fetch described by data and queue the first trip to the 
+ * thread pool. Used by fetchAll and fetchEach.
+ */
+
+void ODBCResult::StartFetchAll(ODBCResult* objODBCResult, fetch_work_data* data) {
+  uv_work_t* work_req = (uv_work_t *) (calloc(1, sizeof(uv_work_t)));
+  
   NanAssignPersistent(data->rows, NanNew<Array>());
   data->errorCount = 0;
   data->count = 0;
   NanAssignPersistent(data->objError, NanNew<Object>());
   
-  data->cb = new NanCallback(cb);
   data->objResult = objODBCResult;
+  data->block = NULL;
+  
+  //the column descriptions are needed so the worker knows how to copy the
+  //rows out of the driver
+  if (objODBCResult->colCount == 0) {
+    objODBCResult->columns = ODBC::GetColumns(
+      objODBCResult->m_hSTMT,
+      &objODBCResult->colCount);
+  }
+  
+  //use a block cursor when more than one row is wanted per trip to the
+  //thread pool and every column can be bound to a fixed size buffer
+  if (data->fetchSize > 1 && objODBCResult->colCount > 0) {
+    bool canBind = true;
+    
+    for (int i = 0; i < objODBCResult->colCount; i++) {
+      if (objODBCResult->columns[i].bindSize == 0) {
+        canBind = false;
+        break;
+      }
+    }
+    
+    if (canBind) {
+      data->block = ODBC::AllocRowBlock(
+        objODBCResult->columns,
+        objODBCResult->colCount,
+        data->fetchSize,
+        true);
+      
+      SQLRETURN ret = ODBC::BindRowBlock(
+        objODBCResult->m_hSTMT,
+        objODBCResult->columns,
+        data->block);
+      
+      if (!SQL_SUCCEEDED(ret)) {
+        //the driver does not support block cursors; fall back to
+        //SQLGetData
+        ODBC::UnbindRowBlock(objODBCResult->m_hSTMT);
+        ODBC::FreeRowBlock(data->block);
+        data->block = NULL;
+      }
+    }
+  }
+  
+  //otherwise fetchSize rows are read with SQLGetData on each trip
+  if (data->block == NULL && objODBCResult->colCount > 0) {
+    data->block = ODBC::AllocRowBlock(
+      objODBCResult->columns,
+      objODBCResult->colCount,
+      data->fetchSize,
+      false);
+  }
+  
+  data->vectors = NULL;
+  NanAssignPersistent(data->columnArrays, NanNew<Array>());
+  
+  if (data->fetchMode == FETCH_COLUMNS && objODBCResult->colCount > 0) {
+    data->vectors = ODBC::AllocColumnVectors(objODBCResult->colCount);
+  }
   
   work_req->data = data;
   
-  uv_queue_work(uv_default_loop(),
+  objODBCResult->m_fetching = true;
+  objODBCResult->m_canceled = false;
+  
+  ODBCWorkerPool::Queue(objODBCResult->m_lock,
     work_req, 
     UV_FetchAll, 
     (uv_after_work_cb)UV_AfterFetchAll);
 
   data->objResult->Ref();
-
-  NanReturnValue(NanUndefined());
 }
 
 void ODBCResult::UV_FetchAll(uv_work_t* work_req) {
@@ -462,8 +697,16 @@ void ODBCResult::UV_FetchAll(uv_work_t* work_req) {
   
   fetch_work_data* data = (fetch_work_data *)(work_req->data);
   
-  data->result = SQLFetch(data->objResult->m_hSTMT);
- }
+  if (data->block) {
+    data->result = ODBC::FetchRowBlock(
+      data->objResult->m_hSTMT,
+      data->objResult->columns,
+      data->block);
+  }
+  else {
+    data->result = SQL_NO_DATA;
+  }
+}
 
 void ODBCResult::UV_AfterFetchAll(uv_work_t* work_req, int status) {
   DEBUG_PRINTF("ODBCResult::UV_AfterFetchAll\n");
@@ -475,69 +718,151 @@ void ODBCResult::UV_AfterFetchAll(uv_work_t* work_req, int status) {
   
   bool doMoreWork = true;
   
-  if (self->colCount == 0) {
-    self->columns = ODBC::GetColumns(self->m_hSTMT, &self->colCount);
-  }
-  
   //check to see if the result set has columns
   if (self->colCount == 0) {
     //this most likely means that the query was something like
     //'insert into ....'
     doMoreWork = false;
   }
-  //check to see if there was an error
-  else if (data->result == SQL_ERROR)  {
+  //check to see if a block fetch returned more data than we bound for
+  else if (ODBC::IsRowBlockTruncated(self->columns, data->block)) {
     data->errorCount++;
     
-    NanAssignPersistent(data->objError, ODBC::GetSQLError(
-      SQL_HANDLE_STMT, 
-      self->m_hSTMT,
-      (char *) "[node-odbc] Error in ODBCResult::UV_AfterFetchAll"
-    ));
+    NanAssignPersistent(data->objError, Exception::Error(NanNew(
+      "[node-odbc] Data truncated in ODBCResult::UV_AfterFetchAll; the driver "
+      "reported a column size that is too small. Use a fetchSize of 1 to "
+      "fetch this result."))->ToObject());
     
     doMoreWork = false;
   }
-  //check to see if we are at the end of the recordset
-  else if (data->result == SQL_NO_DATA) {
-    doMoreWork = false;
-  }
   else {
-    Local<Array> rows = NanNew(data->rows);
-    if (data->fetchMode == FETCH_ARRAY) {
-      rows->Set(
-        NanNew(data->count), 
-        ODBC::GetRecordArray(
-          self->m_hSTMT,
-          self->columns,
-          &self->colCount,
-          self->buffer,
-          self->bufferLength)
-      );
+    //the worker has already copied the rows out of the driver so all
+    //that is left is to turn them into javascript values
+    if (data->fetchMode == FETCH_COLUMNS) {
+      ODBC::AppendColumnVectors(
+        self->columns,
+        &self->colCount,
+        data->block,
+        data->vectors,
+        NanNew(data->columnArrays));
+      
+      data->count += data->block->rowCount;
     }
     else {
-      rows->Set(
-        NanNew(data->count), 
-        ODBC::GetRecordTuple(
-          self->m_hSTMT,
+      Local<Array> rows = NanNew(data->rows);
+      Local<Object> recordTemplate = self->GetRecordTemplate();
+      
+      for (int row = 0; row < (int) data->block->rowCount; row++) {
+        if (data->fetchMode == FETCH_ARRAY) {
+          rows->Set(
+            NanNew(data->count), 
+            ODBC::GetBlockRecordArray(
+              self->columns,
+              &self->colCount,
+              data->block,
+              row)
+          );
+        }
+        else {
+          rows->Set(
+            NanNew(data->count), 
+            ODBC::GetBlockRecordTuple(
+              self->columns,
+              &self->colCount,
+              data->block,
+              row,
+              recordTemplate)
+          );
+        }
+        data->count++;
+      }
+    }
+    
+    //in MODE_CALLBACK_FOR_EACH the batch is handed over now and dropped, so
+    //that only one batch is ever held in memory
+    if (data->mode == MODE_CALLBACK_FOR_EACH && data->block->rowCount > 0) {
+      Handle<Value> args[1];
+      
+      if (data->fetchMode == FETCH_COLUMNS) {
+        args[0] = ODBC::GetColumnVectors(
           self->columns,
           &self->colCount,
-          self->buffer,
-          self->bufferLength)
-      );
+          data->vectors,
+          NanNew(data->columnArrays));
+        
+        ODBC::FreeColumnVectors(data->vectors, self->colCount);
+        data->vectors = ODBC::AllocColumnVectors(self->colCount);
+        NanDisposePersistent(data->columnArrays);
+        NanAssignPersistent(data->columnArrays, NanNew<Array>());
+      }
+      else {
+        args[0] = NanNew(data->rows);
+        
+        NanDisposePersistent(data->rows);
+        NanAssignPersistent(data->rows, NanNew<Array>());
+      }
+      
+      TryCatch try_catch;
+      
+      Local<Value> more = data->each->Call(1, args);
+      
+      if (try_catch.HasCaught()) {
+        FatalException(try_catch);
+      }
+      
+      //returning false from the callback stops the fetch
+      if (!more.IsEmpty() && more->IsFalse()) {
+        doMoreWork = false;
+      }
+    }
+    
+    //check to see if there was an error
+    if (!doMoreWork) {
+      //stopped by the callback
+    }
+    else if (data->result == SQL_ERROR)  {
+      data->errorCount++;
+      
+      NanAssignPersistent(data->objError, ODBC::GetSQLError(
+        SQL_HANDLE_STMT, 
+        self->m_hSTMT,
+        (char *) "[node-odbc] Error in ODBCResult::UV_AfterFetchAll"
+      ));
+      
+      doMoreWork = false;
+    }
+    //canceled between trips, or after the driver had already finished one
+    else if (self->m_canceled) {
+      data->errorCount++;
+      
+      NanAssignPersistent(data->objError, GetCanceledError(
+        (char *) "[node-odbc] Operation canceled in ODBCResult::UV_AfterFetchAll"));
+      
+      doMoreWork = false;
+    }
+    //check to see if we are at the end of the recordset
+    else if (data->result == SQL_NO_DATA) {
+      doMoreWork = false;
     }
-    data->count++;
   }
   
   if (doMoreWork) {
     //Go back to the thread pool and fetch more data!
-    uv_queue_work(
-      uv_default_loop(),
+    ODBCWorkerPool::Queue(
+      self->m_lock,
       work_req, 
       UV_FetchAll, 
       (uv_after_work_cb)UV_AfterFetchAll);
   }
   else {
-    ODBC::FreeColumns(self->columns, &self->colCount);
+    if (data->block) {
+      if (data->block->bound) {
+        ODBC::UnbindRowBlock(self->m_hSTMT);
+      }
+      
+      ODBC::FreeRowBlock(data->block);
+      data->block = NULL;
+    }
     
     Handle<Value> args[2];
     
@@ -548,13 +873,37 @@ void ODBCResult::UV_AfterFetchAll(uv_work_t* work_req, int status) {
       args[0] = NanNull();
     }
     
-    args[1] = NanNew(data->rows);
+    if (data->mode == MODE_CALLBACK_FOR_EACH) {
+      //the rows have already been passed to the each callback
+      args[1] = NanNew(data->count);
+    }
+    else if (data->fetchMode == FETCH_COLUMNS) {
+      args[1] = ODBC::GetColumnVectors(
+        self->columns,
+        &self->colCount,
+        data->vectors,
+        NanNew(data->columnArrays));
+    }
+    else {
+      args[1] = NanNew(data->rows);
+    }
+    
+    ODBC::FreeColumnVectors(data->vectors, self->colCount);
+    self->FreeColumns();
+    
+    self->m_fetching = false;
+    self->m_canceled = false;
 
     TryCatch try_catch;
 
     data->cb->Call(2, args);
     delete data->cb;
+    
+    if (data->each) {
+      delete data->each;
+    }
     NanDisposePersistent(data->rows);
+    NanDisposePersistent(data->columnArrays);
     NanDisposePersistent(data->objError);
 
     if (try_catch.HasCaught()) {
@@ -568,6 +917,401 @@ void ODBCResult::UV_AfterFetchAll(uv_work_t* work_req, int status) {
   }
 }
 
+/*
+ * FetchBatch
+ * 
+ * Call back with the next fetchSize rows, or null at the end of the result.
+ * While javascript is busy with one batch the next one is fetched on the
+ * thread pool; no more than that is read ahead until fetchBatch is called
+ * again.
+ */
+
+NAN_METHOD(ODBCResult::FetchBatch) {
+  DEBUG_PRINTF("ODBCResult::FetchBatch\n");
+  NanScope();
+  
+  ODBCResult* self = ObjectWrap::Unwrap<ODBCResult>(args.Holder());
+  
+  Local<Function> cb;
+  int fetchMode = self->m_fetchMode;
+  int fetchSize = self->m_fetchSize;
+  
+  if (args.Length() == 1 && args[0]->IsFunction()) {
+    cb = Local<Function>::Cast(args[0]);
+  }
+  else if (args.Length() == 2 && args[0]->IsObject() && args[1]->IsFunction()) {
+    cb = Local<Function>::Cast(args[1]);  
+    
+    Local<Object> obj = args[0]->ToObject();
+    
+    Local<String> fetchModeKey = NanNew<String>(OPTION_FETCH_MODE);
+    if (obj->Has(fetchModeKey) && obj->Get(fetchModeKey)->IsInt32()) {
+      fetchMode = obj->Get(fetchModeKey)->ToInt32()->Value();
+    }
+    
+    Local<String> fetchSizeKey = NanNew<String>(OPTION_FETCH_SIZE);
+    if (obj->Has(fetchSizeKey) && obj->Get(fetchSizeKey)->IsInt32()
+        && obj->Get(fetchSizeKey)->ToInt32()->Value() > 0) {
+      fetchSize = obj->Get(fetchSizeKey)->ToInt32()->Value();
+    }
+  }
+  else {
+    return NanThrowTypeError("ODBCResult::FetchBatch(): 1 or 2 arguments are required. The last argument must be a callback function.");
+  }
+  
+  if (self->m_batch && self->m_batch->cb) {
+    return NanThrowError("ODBCResult::FetchBatch(): the previous call to fetchBatch has not called back yet.");
+  }
+  
+  //closed, and nothing left running on the statement to report it
+  if (self->m_hSTMT == NULL && self->m_batch == NULL) {
+    Handle<Value> argv[2];
+    
+    argv[0] = Exception::Error(NanNew(
+      "[node-odbc] The result was closed in ODBCResult::FetchBatch"));
+    argv[1] = NanNull();
+    
+    NanCallback callback(cb);
+    TryCatch try_catch;
+    
+    callback.Call(2, argv);
+    
+    if (try_catch.HasCaught()) {
+      FatalException(try_catch);
+    }
+    
+    NanReturnValue(NanUndefined());
+  }
+  
+  if (self->m_batch == NULL) {
+    fetch_batch_state* state = (fetch_batch_state *) calloc(1, sizeof(fetch_batch_state));
+    
+    state->fetchMode = fetchMode;
+    
+    if (self->colCount == 0) {
+      self->columns = ODBC::GetColumns(self->m_hSTMT, &self->colCount);
+    }
+    
+    if (self->colCount > 0) {
+      bool canBind = fetchSize > 1;
+      
+      for (int i = 0; canBind && i < self->colCount; i++) {
+        canBind = self->columns[i].bindSize > 0;
+      }
+      
+      //check that the driver will take a block cursor before committing to
+      //one; the blocks are bound again on each trip to the thread pool
+      if (canBind) {
+        RowBlock* block = ODBC::AllocRowBlock(self->columns, self->colCount, fetchSize, true);
+        
+        if (!SQL_SUCCEEDED(ODBC::BindRowBlock(self->m_hSTMT, self->columns, block))) {
+          ODBC::UnbindRowBlock(self->m_hSTMT);
+          canBind = false;
+        }
+        
+        ODBC::FreeRowBlock(block);
+      }
+      
+      for (int i = 0; i < 2; i++) {
+        state->blocks[i] = ODBC::AllocRowBlock(
+          self->columns,
+          self->colCount,
+          fetchSize,
+          canBind);
+      }
+    }
+    
+    self->m_batch = state;
+    self->m_fetching = true;
+    self->m_canceled = false;
+  }
+  
+  self->m_batch->cb = new NanCallback(cb);
+  
+  if (self->m_batch->ready) {
+    DeliverFetchBatch(self);
+  }
+  else if (!self->m_batch->fetching) {
+    QueueFetchBatch(self);
+  }
+  //otherwise the batch being fetched now will be delivered when it is done
+  
+  NanReturnValue(NanUndefined());
+}
+
+void ODBCResult::QueueFetchBatch(ODBCResult* self) {
+  DEBUG_PRINTF("ODBCResult::QueueFetchBatch\n");
+  
+  uv_work_t* work_req = (uv_work_t *) (calloc(1, sizeof(uv_work_t)));
+  
+  fetch_batch_work_data* data = 
+    (fetch_batch_work_data *) calloc(1, sizeof(fetch_batch_work_data));
+  
+  data->objResult = self;
+  data->block = self->m_batch->blocks[self->m_batch->current];
+  
+  self->m_batch->fetching = true;
+  self->m_batch->ready = false;
+  
+  work_req->data = data;
+  
+  ODBCWorkerPool::Queue(
+    self->m_lock,
+    work_req,
+    UV_FetchBatch,
+    (uv_after_work_cb)UV_AfterFetchBatch);
+  
+  self->Ref();
+}
+
+void ODBCResult::UV_FetchBatch(uv_work_t* work_req) {
+  DEBUG_PRINTF("ODBCResult::UV_FetchBatch\n");
+  
+  fetch_batch_work_data* data = (fetch_batch_work_data *)(work_req->data);
+  
+  if (data->block == NULL) {
+    data->result = SQL_NO_DATA;
+    
+    return;
+  }
+  
+  if (data->block->bound) {
+    data->result = ODBC::BindRowBlock(
+      data->objResult->m_hSTMT,
+      data->objResult->columns,
+      data->block);
+    
+    if (!SQL_SUCCEEDED(data->result)) {
+      return;
+    }
+  }
+  
+  data->result = ODBC::FetchRowBlock(
+    data->objResult->m_hSTMT,
+    data->objResult->columns,
+    data->block);
+}
+
+void ODBCResult::UV_AfterFetchBatch(uv_work_t* work_req, int status) {
+  DEBUG_PRINTF("ODBCResult::UV_AfterFetchBatch\n");
+  NanScope();
+  
+  fetch_batch_work_data* data = (fetch_batch_work_data *)(work_req->data);
+  
+  ODBCResult* self = data->objResult->self();
+  
+  self->m_batch->fetching = false;
+  self->m_batch->ready = true;
+  self->m_batch->result = data->result;
+  
+  free(data);
+  free(work_req);
+  
+  //the result was closed while this batch was being fetched
+  if (self->m_batch->closing) {
+    NanCallback* cb = self->m_batch->cb;
+    int closeOption = self->m_batch->closeOption;
+    
+    self->m_batch->cb = NULL;
+    
+    FreeFetchBatch(self);
+    self->Close(closeOption);
+    
+    if (cb) {
+      Handle<Value> args[2];
+      
+      args[0] = Exception::Error(NanNew(
+        "[node-odbc] The result was closed in ODBCResult::FetchBatch"));
+      args[1] = NanNull();
+      
+      TryCatch try_catch;
+      
+      cb->Call(2, args);
+      delete cb;
+      
+      if (try_catch.HasCaught()) {
+        FatalException(try_catch);
+      }
+    }
+    
+    self->Unref();
+    
+    return;
+  }
+  
+  //only hand the batch over if someone is waiting for it
+  if (self->m_batch->cb) {
+    DeliverFetchBatch(self);
+  }
+  
+  self->Unref();
+}
+
+void ODBCResult::DeliverFetchBatch(ODBCResult* self) {
+  DEBUG_PRINTF("ODBCResult::DeliverFetchBatch\n");
+  NanScope();
+  
+  fetch_batch_state* state = self->m_batch;
+  RowBlock* block = state->blocks[state->current];
+  NanCallback* cb = state->cb;
+  SQLRETURN ret = state->result;
+  Handle<Value> args[2];
+  
+  state->cb = NULL;
+  state->ready = false;
+  
+  args[0] = NanNull();
+  args[1] = NanNull();
+  
+  bool truncated = (block != NULL && ODBC::IsRowBlockTruncated(self->columns, block));
+  bool canceled = (self->m_canceled && ret != SQL_ERROR);
+  bool moreWork = (block != NULL && SQL_SUCCEEDED(ret) && !truncated && !canceled);
+  
+  if (moreWork) {
+    //start on the next batch while we convert this one
+    state->current = (state->current + 1) % 2;
+    
+    QueueFetchBatch(self);
+  }
+  
+  if (truncated) {
+    args[0] = Exception::Error(NanNew(
+      "[node-odbc] Data truncated in ODBCResult::FetchBatch; the driver "
+      "reported a column size that is too small. Use a fetchSize of 1 to "
+      "fetch this result."));
+  }
+  else if (ret == SQL_ERROR) {
+    args[0] = ODBC::GetSQLError(
+      SQL_HANDLE_STMT,
+      self->m_hSTMT,
+      (char *) "[node-odbc] Error in ODBCResult::FetchBatch");
+  }
+  else if (canceled) {
+    args[0] = GetCanceledError(
+      (char *) "[node-odbc] Operation canceled in ODBCResult::FetchBatch");
+  }
+  
+  if (!truncated && !canceled && block != NULL && block->rowCount > 0) {
+    if (state->fetchMode == FETCH_COLUMNS) {
+      ColumnVector* vectors = ODBC::AllocColumnVectors(self->colCount);
+      Local<Array> arrays = NanNew<Array>();
+      
+      ODBC::AppendColumnVectors(self->columns, &self->colCount, block, vectors, arrays);
+      
+      args[1] = ODBC::GetColumnVectors(self->columns, &self->colCount, vectors, arrays);
+      
+      ODBC::FreeColumnVectors(vectors, self->colCount);
+    }
+    else {
+      Local<Array> rows = NanNew<Array>();
+      Local<Object> recordTemplate = self->GetRecordTemplate();
+      
+      for (int row = 0; row < (int) block->rowCount; row++) {
+        if (state->fetchMode == FETCH_ARRAY) {
+          rows->Set(row, ODBC::GetBlockRecordArray(
+            self->columns,
+            &self->colCount,
+            block,
+            row));
+        }
+        else {
+          rows->Set(row, ODBC::GetBlockRecordTuple(
+            self->columns,
+            &self->colCount,
+            block,
+            row,
+            recordTemplate));
+        }
+      }
+      
+      args[1] = rows;
+    }
+  }
+  
+  if (!moreWork) {
+    FreeFetchBatch(self);
+    self->FreeColumns();
+  }
+  
+  TryCatch try_catch;
+  
+  cb->Call(2, args);
+  delete cb;
+  
+  if (try_catch.HasCaught()) {
+    FatalException(try_catch);
+  }
+}
+
+void ODBCResult::FreeFetchBatch(ODBCResult* self) {
+  fetch_batch_state* state = self->m_batch;
+  
+  if (state == NULL) {
+    return;
+  }
+  
+  if (state->blocks[0] && state->blocks[0]->bound) {
+    ODBC::UnbindRowBlock(self->m_hSTMT);
+  }
+  
+  ODBC::FreeRowBlock(state->blocks[0]);
+  ODBC::FreeRowBlock(state->blocks[1]);
+  
+  delete state->cb;
+  free(state);
+  
+  self->m_batch = NULL;
+  self->m_fetching = false;
+  self->m_canceled = false;
+}
+
+Local<Object> ODBCResult::GetCanceledError(char* message) {
+  NanEscapableScope();
+  
+  Local<Object> objError = Exception::Error(NanNew(message))->ToObject();
+  
+  objError->Set(NanNew("state"), NanNew("HY008"));
+  
+  return NanEscapeScope(objError);
+}
+
+/*
+ * GetRecordTemplate
+ * 
+ * The result's record template, made the first time it is asked for so that
+ * fetching one row at a time does not make a new one for every row.
+ */
+
+Local<Object> ODBCResult::GetRecordTemplate() {
+  NanEscapableScope();
+  
+  if (recordTemplate == NULL) {
+    recordTemplate = new Persistent<Object>();
+    NanAssignPersistent(
+      *recordTemplate, 
+      ODBC::GetRecordTemplate(columns, &colCount));
+  }
+  
+  return NanEscapeScope(NanNew(*recordTemplate));
+}
+
+/*
+ * FreeColumns
+ * 
+ * Free the columns and the record template made from them.
+ */
+
+void ODBCResult::FreeColumns() {
+  if (recordTemplate != NULL) {
+    NanDisposePersistent(*recordTemplate);
+    delete recordTemplate;
+    
+    recordTemplate = NULL;
+  }
+  
+  ODBC::FreeColumns(columns, &colCount);
+}
+
 /*
  * FetchAllSync
  */
@@ -600,8 +1344,55 @@ NAN_METHOD(ODBCResult::FetchAllSync) {
   
   Local<Array> rows = NanNew<Array>();
   
+  if (fetchMode == FETCH_COLUMNS) {
+    Local<Array> arrays = NanNew<Array>();
+    RowBlock* block = NULL;
+    ColumnVector* vectors = NULL;
+    
+    if (self->colCount > 0) {
+      block = ODBC::AllocRowBlock(self->columns, self->colCount, self->m_fetchSize, false);
+      vectors = ODBC::AllocColumnVectors(self->colCount);
+      
+      do {
+        ret = ODBC::FetchRowBlock(self->m_hSTMT, self->columns, block);
+        
+        ODBC::AppendColumnVectors(self->columns, &self->colCount, block, vectors, arrays);
+      } while (SQL_SUCCEEDED(ret));
+      
+      //check to see if there was an error
+      if (ret == SQL_ERROR) {
+        errorCount++;
+        
+        objError = ODBC::GetSQLError(
+          SQL_HANDLE_STMT, 
+          self->m_hSTMT,
+          (char *) "[node-odbc] Error in ODBCResult::FetchAllSync"
+        );
+      }
+    }
+    
+    Local<Object> result = ODBC::GetColumnVectors(
+      self->columns,
+      &self->colCount,
+      vectors,
+      arrays);
+    
+    ODBC::FreeRowBlock(block);
+    ODBC::FreeColumnVectors(vectors, self->colCount);
+    self->FreeColumns();
+    
+    //throw the error object if there were errors
+    if (errorCount > 0) {
+      NanThrowError(objError);
+    }
+    
+    NanReturnValue(result);
+  }
+  
   //Only loop through the recordset if there are columns
   if (self->colCount > 0) {
+    Local<Object> recordTemplate = self->GetRecordTemplate();
+    
     //loop through all records
     while (true) {
       ret = SQLFetch(self->m_hSTMT);
@@ -622,7 +1413,7 @@ NAN_METHOD(ODBCResult::FetchAllSync) {
       
       //check to see if we are at the end of the recordset
       if (ret == SQL_NO_DATA) {
-        ODBC::FreeColumns(self->columns, &self->colCount);
+        self->FreeColumns();
         
         break;
       }
@@ -646,14 +1437,15 @@ NAN_METHOD(ODBCResult::FetchAllSync) {
             self->columns,
             &self->colCount,
             self->buffer,
-            self->bufferLength)
+            self->bufferLength,
+            recordTemplate)
         );
       }
       count++;
     }
   }
   else {
-    ODBC::FreeColumns(self->columns, &self->colCount);
+    self->FreeColumns();
   }
   
   //throw the error object if there were errors
@@ -664,6 +1456,44 @@ NAN_METHOD(ODBCResult::FetchAllSync) {
   NanReturnValue(rows);
 }
 
+/*
+ * Cancel
+ * 
+ * Cancel the statement behind the result from the main thread. A fetchAll 
+ * or fetchEach in progress stops at the next block and calls back with a
+ * cancellation error.
+ */
+
+NAN_METHOD(ODBCResult::Cancel) {
+  DEBUG_PRINTF("ODBCResult::Cancel\n");
+  NanScope();
+  
+  ODBCResult* result = ObjectWrap::Unwrap<ODBCResult>(args.Holder());
+  
+  //there is nothing to cancel once the result has been closed
+  if (result->m_hSTMT == NULL) {
+    NanReturnValue(NanFalse());
+  }
+  
+  //only a fetch that is running now is told it was canceled; SQLCancel does
+  //nothing to a statement that is not doing anything
+  result->m_canceled = result->m_fetching;
+  
+  SQLRETURN ret = SQLCancel(result->m_hSTMT);
+  
+  if (!SQL_SUCCEEDED(ret)) {
+    NanThrowError(ODBC::GetSQLError(
+      SQL_HANDLE_STMT,
+      result->m_hSTMT,
+      (char *) "[node-odbc] Error in ODBCResult::Cancel"
+    ));
+    
+    NanReturnValue(NanFalse());
+  }
+  
+  NanReturnValue(NanTrue());
+}
+
 /*
  * CloseSync
  * 
@@ -680,26 +1510,40 @@ NAN_METHOD(ODBCResult::CloseSync) {
   DEBUG_PRINTF("ODBCResult::CloseSync closeOption=%i m_canFreeHandle=%i\n", 
                closeOption, result->m_canFreeHandle);
   
-  if (closeOption == SQL_DESTROY && result->m_canFreeHandle) {
-    result->Free();
+  if (result->m_batch && result->m_batch->fetching) {
+    //a fetchBatch read-ahead is still using the handle; UV_AfterFetchBatch
+    //closes it once the fetch has been stopped
+    result->m_batch->closing = true;
+    result->m_batch->closeOption = closeOption;
+    
+    SQLCancel(result->m_hSTMT);
+  }
+  else {
+    result->Close(closeOption);
+  }
+  
+  NanReturnValue(NanTrue());
+}
+
+void ODBCResult::Close(int closeOption) {
+  if (closeOption == SQL_DESTROY && m_canFreeHandle) {
+    Free();
   }
-  else if (closeOption == SQL_DESTROY && !result->m_canFreeHandle) {
+  else if (closeOption == SQL_DESTROY && !m_canFreeHandle) {
     //We technically can't free the handle so, we'll SQL_CLOSE
-    uv_mutex_lock(&ODBC::g_odbcMutex);
+    uv_mutex_t* locked = ODBC::LockDriver(m_lock);
     
-    SQLFreeStmt(result->m_hSTMT, SQL_CLOSE);
+    SQLFreeStmt(m_hSTMT, SQL_CLOSE);
   
-    uv_mutex_unlock(&ODBC::g_odbcMutex);
+    ODBC::UnlockDriver(locked);
   }
   else {
-    uv_mutex_lock(&ODBC::g_odbcMutex);
+    uv_mutex_t* locked = ODBC::LockDriver(m_lock);
     
-    SQLFreeStmt(result->m_hSTMT, closeOption);
+    SQLFreeStmt(m_hSTMT, closeOption);
   
-    uv_mutex_unlock(&ODBC::g_odbcMutex);
+    ODBC::UnlockDriver(locked);
   }
-  
-  NanReturnValue(NanTrue());
 }
 
 NAN_METHOD(ODBCResult::MoreResultsSync) {
@@ -734,8 +1578,7 @@ NAN_METHOD(ODBCResult::GetColumnNamesSync) {
   }
   
   for (int i = 0; i < self->colCount; i++) {
-    cols->Set(NanNew(i),
-              NanNew((const char *) self->columns[i].name));
+    cols->Set(NanNew(i), NanNew(*self->columns[i].key));
   }
     
   NanReturnValue(cols);
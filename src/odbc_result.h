@@ -22,10 +22,12 @@
 class ODBCResult : public node::ObjectWrap {
   public:
    static Persistent<String> OPTION_FETCH_MODE;
+   static Persistent<String> OPTION_FETCH_SIZE;
    static Persistent<Function> constructor;
    static void Init(v8::Handle<Object> exports);
    
    void Free();
+   void Close(int closeOption);
    
   protected:
     ODBCResult() {};
@@ -50,6 +52,15 @@ class ODBCResult : public node::ObjectWrap {
     static NAN_METHOD(FetchAll);
     static void UV_FetchAll(uv_work_t* work_req);
     static void UV_AfterFetchAll(uv_work_t* work_req, int status);
+
+    static NAN_METHOD(FetchEach);
+
+    static NAN_METHOD(FetchBatch);
+    static void UV_FetchBatch(uv_work_t* work_req);
+    static void UV_AfterFetchBatch(uv_work_t* work_req, int status);
+    static void QueueFetchBatch(ODBCResult* self);
+    static void DeliverFetchBatch(ODBCResult* self);
+    static void FreeFetchBatch(ODBCResult* self);
     
     //sync methods
     static NAN_METHOD(CloseSync);
@@ -57,36 +68,81 @@ class ODBCResult : public node::ObjectWrap {
     static NAN_METHOD(FetchSync);
     static NAN_METHOD(FetchAllSync);
     static NAN_METHOD(GetColumnNamesSync);
+    static NAN_METHOD(Cancel);
     
     //property getter/setters
     static NAN_GETTER(FetchModeGetter);
     static NAN_SETTER(FetchModeSetter);
+    static NAN_GETTER(FetchSizeGetter);
+    static NAN_SETTER(FetchSizeSetter);
     
     struct fetch_work_data {
       NanCallback* cb;
+      NanCallback* each;
       ODBCResult *objResult;
       SQLRETURN result;
       
+      int mode;
       int fetchMode;
+      int fetchSize;
+      RowBlock *block;
+      ColumnVector *vectors;
       int count;
       int errorCount;
       Persistent<Array> rows;
+      Persistent<Array> columnArrays;
       Persistent<Object> objError;
     };
     
+    //fetchBatch keeps two blocks; the worker fills one while the rows in
+    //the other are handed to javascript
+    struct fetch_batch_state {
+      RowBlock *blocks[2];
+      int current;
+      bool fetching;
+      bool ready;
+      bool closing;
+      int closeOption;
+      SQLRETURN result;
+      int fetchMode;
+      NanCallback* cb;
+    };
+    
+    struct fetch_batch_work_data {
+      ODBCResult *objResult;
+      RowBlock *block;
+      SQLRETURN result;
+    };
+    
+    static void StartFetchAll(ODBCResult* self, fetch_work_data* data);
+    static Local<Object> GetCanceledError(char* message);
+    
+    Local<Object> GetRecordTemplate();
+    void FreeColumns();
+    
     ODBCResult *self(void) { return this; }
 
   protected:
     HENV m_hENV;
     HDBC m_hDBC;
     HSTMT m_hSTMT;
+    DriverLock *m_lock;
     bool m_canFreeHandle;
     int m_fetchMode;
+    int m_fetchSize;
+    fetch_batch_state *m_batch;
+    //m_fetching is set from the start to the end of a fetch, fetchAll,
+    //fetchEach or fetchBatch; m_canceled is set by cancel() during one
+    bool m_fetching;
+    bool m_canceled;
     
     uint16_t *buffer;
     int bufferLength;
     Column *columns;
     short colCount;
+    //made from columns the first time a row is fetched as an object and
+    //kept until they are freed
+    Persistent<Object> *recordTemplate;
 };
 
 
@@ -25,6 +25,7 @@
 #include "odbc_connection.h"
 #include "odbc_result.h"
 #include "odbc_statement.h"
+#include "odbc_worker_pool.h"
 
 using namespace v8;
 using namespace node;
@@ -45,6 +46,10 @@ void ODBCStatement::Init(v8::Handle<Object> exports) {
   Local<ObjectTemplate> instance_template = t->InstanceTemplate();
   instance_template->SetInternalFieldCount(1);
   
+  // Properties
+  instance_template->SetAccessor(NanNew("asyncPolling"), AsyncPollingGetter, AsyncPollingSetter);
+  instance_template->SetAccessor(NanNew("queryTimeout"), QueryTimeoutGetter, QueryTimeoutSetter);
+  
   // Prototype Methods
   NODE_SET_PROTOTYPE_METHOD(t, "execute", Execute);
   NODE_SET_PROTOTYPE_METHOD(t, "executeSync", ExecuteSync);
@@ -55,12 +60,17 @@ void ODBCStatement::Init(v8::Handle<Object> exports) {
   NODE_SET_PROTOTYPE_METHOD(t, "executeNonQuery", ExecuteNonQuery);
   NODE_SET_PROTOTYPE_METHOD(t, "executeNonQuerySync", ExecuteNonQuerySync);
   
+  NODE_SET_PROTOTYPE_METHOD(t, "executeBatch", ExecuteBatch);
+  
   NODE_SET_PROTOTYPE_METHOD(t, "prepare", Prepare);
   NODE_SET_PROTOTYPE_METHOD(t, "prepareSync", PrepareSync);
   
   NODE_SET_PROTOTYPE_METHOD(t, "bind", Bind);
   NODE_SET_PROTOTYPE_METHOD(t, "bindSync", BindSync);
   
+  NODE_SET_PROTOTYPE_METHOD(t, "putData", PutData);
+  NODE_SET_PROTOTYPE_METHOD(t, "cancel", Cancel);
+  
   NODE_SET_PROTOTYPE_METHOD(t, "closeSync", CloseSync);
 
   // Attach the Database Constructor to the target object
@@ -70,6 +80,8 @@ void ODBCStatement::Init(v8::Handle<Object> exports) {
 
 ODBCStatement::~ODBCStatement() {
   this->Free();
+  
+  ODBC::ReleaseDriverLock(m_lock);
 }
 
 void ODBCStatement::Free() {
@@ -79,31 +91,21 @@ void ODBCStatement::Free() {
     int count = paramCount;
     paramCount = 0;
     
-    Parameter prm;
-    
-    //free parameter memory
-    for (int i = 0; i < count; i++) {
-      if (prm = params[i], prm.ParameterValuePtr != NULL) {
-        switch (prm.ValueType) {
-          case SQL_C_WCHAR:   free(prm.ParameterValuePtr);             break;
-          case SQL_C_CHAR:    free(prm.ParameterValuePtr);             break; 
-          case SQL_C_SBIGINT: delete (int64_t *)prm.ParameterValuePtr; break;
-          case SQL_C_DOUBLE:  delete (double  *)prm.ParameterValuePtr; break;
-          case SQL_C_BIT:     delete (bool    *)prm.ParameterValuePtr; break;
-        }
-      }
-    }
-
-    free(params);
+    ODBC::FreeParameters(params, count);
+    params = NULL;
   }
   
+  m_paramsBound = false;
+  
+  SetParameterDescriptions(NULL, 0);
+  
   if (m_hSTMT) {
-    uv_mutex_lock(&ODBC::g_odbcMutex);
+    uv_mutex_t* locked = ODBC::LockDriver(m_lock);
     
     SQLFreeHandle(SQL_HANDLE_STMT, m_hSTMT);
     m_hSTMT = NULL;
     
-    uv_mutex_unlock(&ODBC::g_odbcMutex);
+    ODBC::UnlockDriver(locked);
     
     if (bufferLength > 0) {
       free(buffer);
@@ -118,6 +120,7 @@ NAN_METHOD(ODBCStatement::New) {
   REQ_EXT_ARG(0, js_henv);
   REQ_EXT_ARG(1, js_hdbc);
   REQ_EXT_ARG(2, js_hstmt);
+  REQ_EXT_ARG(3, js_lock);
   
   HENV hENV = static_cast<HENV>(js_henv->Value());
   HDBC hDBC = static_cast<HDBC>(js_hdbc->Value());
@@ -126,6 +129,10 @@ NAN_METHOD(ODBCStatement::New) {
   //create a new OBCResult object
   ODBCStatement* stmt = new ODBCStatement(hENV, hDBC, hSTMT);
   
+  //share the connection's lock
+  stmt->m_lock = static_cast<DriverLock *>(js_lock->Value());
+  ODBC::RetainDriverLock(stmt->m_lock);
+  
   //specify the buffer length
   stmt->bufferLength = MAX_VALUE_SIZE - 1;
   
@@ -138,12 +145,69 @@ NAN_METHOD(ODBCStatement::New) {
   
   //initialize the paramCount
   stmt->paramCount = 0;
+  stmt->params = NULL;
+  stmt->m_paramsBound = false;
+  stmt->m_executeNonQuery = false;
+  stmt->m_asyncPolling = false;
+  stmt->m_queryTimeout = 0;
+  stmt->m_paramDescriptions = NULL;
+  stmt->m_paramDescriptionCount = 0;
   
   stmt->Wrap(args.Holder());
   
   NanReturnValue(args.Holder());
 }
 
+NAN_GETTER(ODBCStatement::AsyncPollingGetter) {
+  NanScope();
+
+  ODBCStatement *obj = ObjectWrap::Unwrap<ODBCStatement>(args.Holder());
+
+  NanReturnValue(NanNew<Boolean>(obj->m_asyncPolling));
+}
+
+NAN_SETTER(ODBCStatement::AsyncPollingSetter) {
+  NanScope();
+
+  ODBCStatement *obj = ObjectWrap::Unwrap<ODBCStatement>(args.Holder());
+  
+  obj->m_asyncPolling = value->BooleanValue();
+}
+
+NAN_GETTER(ODBCStatement::QueryTimeoutGetter) {
+  NanScope();
+
+  ODBCStatement *obj = ObjectWrap::Unwrap<ODBCStatement>(args.Holder());
+
+  NanReturnValue(NanNew<Number>(obj->m_queryTimeout));
+}
+
+NAN_SETTER(ODBCStatement::QueryTimeoutSetter) {
+  NanScope();
+
+  ODBCStatement *obj = ObjectWrap::Unwrap<ODBCStatement>(args.Holder());
+  
+  if (value->IsNumber()) {
+    SQLRETURN ret = SQLSetStmtAttr(
+      obj->m_hSTMT,
+      SQL_ATTR_QUERY_TIMEOUT,
+      (SQLPOINTER) size_t(value->Uint32Value()),
+      0);
+    
+    if (!SQL_SUCCEEDED(ret)) {
+      NanThrowError(ODBC::GetSQLError(
+        SQL_HANDLE_STMT,
+        obj->m_hSTMT,
+        (char *) "[node-odbc] Error in ODBCStatement::QueryTimeoutSetter"
+      ));
+      
+      return;
+    }
+    
+    obj->m_queryTimeout = value->Uint32Value();
+  }
+}
+
 /*
  * Execute
  */
@@ -153,25 +217,44 @@ NAN_METHOD(ODBCStatement::Execute) {
   
   NanScope();
 
-  REQ_FUN_ARG(0, cb);
-
   ODBCStatement* stmt = ObjectWrap::Unwrap<ODBCStatement>(args.Holder());
   
+  Local<Function> cb;
+  bool rebind = false;
+  
+  //handle execute([values], cb) as well as execute(cb)
+  if (args.Length() >= 2 && args[0]->IsArray() && args[1]->IsFunction()) {
+    rebind = stmt->SetParameters(Local<Array>::Cast(args[0]));
+    cb = Local<Function>::Cast(args[1]);
+  }
+  else if (args.Length() >= 1 && args[0]->IsFunction()) {
+    cb = Local<Function>::Cast(args[0]);
+  }
+  else {
+    return NanThrowTypeError("Argument 0 must be an Array or a function");
+  }
+  
   uv_work_t* work_req = (uv_work_t *) (calloc(1, sizeof(uv_work_t)));
   
   execute_work_data* data = 
     (execute_work_data *) calloc(1, sizeof(execute_work_data));
 
   data->cb = new NanCallback(cb);
+  data->rebind = rebind;
   
   data->stmt = stmt;
   work_req->data = data;
   
-  uv_queue_work(
-    uv_default_loop(),
-    work_req,
-    UV_Execute,
-    (uv_after_work_cb)UV_AfterExecute);
+  //putData needs to know how to finish once the last parameter is sent
+  stmt->m_executeNonQuery = false;
+  
+  if (!stmt->StartExecuteAsync(work_req, (uv_after_work_cb)UV_AfterExecute)) {
+    ODBCWorkerPool::Queue(
+      stmt->m_lock,
+      work_req,
+      UV_Execute,
+      (uv_after_work_cb)UV_AfterExecute);
+  }
 
   stmt->Ref();
 
@@ -183,9 +266,19 @@ void ODBCStatement::UV_Execute(uv_work_t* req) {
   
   execute_work_data* data = (execute_work_data *)(req->data);
 
-  SQLRETURN ret;
+  SQLRETURN ret = SQL_SUCCESS;
+  
+  if (data->rebind) {
+    ret = data->stmt->BindParameters();
+  }
   
-  ret = SQLExecute(data->stmt->m_hSTMT); 
+  if (ret != SQL_ERROR) {
+    ret = SQLExecute(data->stmt->m_hSTMT); 
+  }
+  
+  if (ret == SQL_NEED_DATA) {
+    ret = data->stmt->ParamData(&data->param);
+  }
 
   data->result = ret;
 }
@@ -207,16 +300,34 @@ void ODBCStatement::UV_AfterExecute(uv_work_t* req, int status) {
       self->m_hSTMT,
       data->cb);
   }
+  else if (data->result == SQL_NEED_DATA) {
+    //the caller has to send this parameter with putData before we know
+    //how the statement went
+    Local<Value> args[3];
+    
+    args[0] = NanNew<Value>(NanNull());
+    args[1] = NanNew<Value>(NanNull());
+    args[2] = NanNew<Number>(data->param);
+    
+    TryCatch try_catch;
+    
+    data->cb->Call(3, args);
+    
+    if (try_catch.HasCaught()) {
+      FatalException(try_catch);
+    }
+  }
   else {
-    Local<Value> args[4];
+    Local<Value> args[5];
     bool* canFreeHandle = new bool(false);
 
     args[0] = NanNew<External>(self->m_hENV);
     args[1] = NanNew<External>(self->m_hDBC);
     args[2] = NanNew<External>(self->m_hSTMT);
     args[3] = NanNew<External>(canFreeHandle);
+    args[4] = NanNew<External>(self->m_lock);
     
-    Local<Object> js_result = NanNew(ODBCResult::constructor)->NewInstance(4, args);
+    Local<Object> js_result = NanNew(ODBCResult::constructor)->NewInstance(5, args);
 
     args[0] = NanNew<Value>(NanNull());
     args[1] = NanNew(js_result);
@@ -232,6 +343,7 @@ void ODBCStatement::UV_AfterExecute(uv_work_t* req, int status) {
 
   self->Unref();
   delete data->cb;
+  NanDisposePersistent(data->chunk);
   
   free(data);
   free(req);
@@ -261,15 +373,16 @@ NAN_METHOD(ODBCStatement::ExecuteSync) {
     NanReturnValue(NanNull());
   }
   else {
-    Local<Value> result[4];
+    Local<Value> result[5];
     bool* canFreeHandle = new bool(false);
     
     result[0] = NanNew<External>(stmt->m_hENV);
     result[1] = NanNew<External>(stmt->m_hDBC);
     result[2] = NanNew<External>(stmt->m_hSTMT);
     result[3] = NanNew<External>(canFreeHandle);
+    result[4] = NanNew<External>(stmt->m_lock);
     
-    Local<Object> js_result = NanNew(ODBCResult::constructor)->NewInstance(4, result);
+    Local<Object> js_result = NanNew(ODBCResult::constructor)->NewInstance(5, result);
 
     NanReturnValue(js_result);
   }
@@ -284,25 +397,44 @@ NAN_METHOD(ODBCStatement::ExecuteNonQuery) {
   
   NanScope();
 
-  REQ_FUN_ARG(0, cb);
-
   ODBCStatement* stmt = ObjectWrap::Unwrap<ODBCStatement>(args.Holder());
   
+  Local<Function> cb;
+  bool rebind = false;
+  
+  //handle executeNonQuery([values], cb) as well as executeNonQuery(cb)
+  if (args.Length() >= 2 && args[0]->IsArray() && args[1]->IsFunction()) {
+    rebind = stmt->SetParameters(Local<Array>::Cast(args[0]));
+    cb = Local<Function>::Cast(args[1]);
+  }
+  else if (args.Length() >= 1 && args[0]->IsFunction()) {
+    cb = Local<Function>::Cast(args[0]);
+  }
+  else {
+    return NanThrowTypeError("Argument 0 must be an Array or a function");
+  }
+  
   uv_work_t* work_req = (uv_work_t *) (calloc(1, sizeof(uv_work_t)));
   
   execute_work_data* data = 
     (execute_work_data *) calloc(1, sizeof(execute_work_data));
 
   data->cb = new NanCallback(cb);
+  data->rebind = rebind;
   
   data->stmt = stmt;
   work_req->data = data;
   
-  uv_queue_work(
-    uv_default_loop(),
-    work_req,
-    UV_ExecuteNonQuery,
-    (uv_after_work_cb)UV_AfterExecuteNonQuery);
+  //putData needs to know how to finish once the last parameter is sent
+  stmt->m_executeNonQuery = true;
+  
+  if (!stmt->StartExecuteAsync(work_req, (uv_after_work_cb)UV_AfterExecuteNonQuery)) {
+    ODBCWorkerPool::Queue(
+      stmt->m_lock,
+      work_req,
+      UV_ExecuteNonQuery,
+      (uv_after_work_cb)UV_AfterExecuteNonQuery);
+  }
 
   stmt->Ref();
   
@@ -314,9 +446,19 @@ void ODBCStatement::UV_ExecuteNonQuery(uv_work_t* req) {
   
   execute_work_data* data = (execute_work_data *)(req->data);
 
-  SQLRETURN ret;
+  SQLRETURN ret = SQL_SUCCESS;
+  
+  if (data->rebind) {
+    ret = data->stmt->BindParameters();
+  }
   
-  ret = SQLExecute(data->stmt->m_hSTMT); 
+  if (ret != SQL_ERROR) {
+    ret = SQLExecute(data->stmt->m_hSTMT); 
+  }
+  
+  if (ret == SQL_NEED_DATA) {
+    ret = data->stmt->ParamData(&data->param);
+  }
 
   data->result = ret;
 }
@@ -338,6 +480,23 @@ void ODBCStatement::UV_AfterExecuteNonQuery(uv_work_t* req, int status) {
       self->m_hSTMT,
       data->cb);
   }
+  else if (data->result == SQL_NEED_DATA) {
+    //the caller has to send this parameter with putData before we know
+    //how the statement went
+    Local<Value> args[3];
+    
+    args[0] = NanNew<Value>(NanNull());
+    args[1] = NanNew<Value>(NanNull());
+    args[2] = NanNew<Number>(data->param);
+    
+    TryCatch try_catch;
+    
+    data->cb->Call(3, args);
+    
+    if (try_catch.HasCaught()) {
+      FatalException(try_catch);
+    }
+  }
   else {
     SQLLEN rowCount = 0;
     
@@ -347,9 +506,9 @@ void ODBCStatement::UV_AfterExecuteNonQuery(uv_work_t* req, int status) {
       rowCount = 0;
     }
     
-    uv_mutex_lock(&ODBC::g_odbcMutex);
+    uv_mutex_t* locked = ODBC::LockDriver(self->m_lock);
     SQLFreeStmt(self->m_hSTMT, SQL_CLOSE);
-    uv_mutex_unlock(&ODBC::g_odbcMutex);
+    ODBC::UnlockDriver(locked);
     
     Local<Value> args[2];
 
@@ -368,6 +527,7 @@ void ODBCStatement::UV_AfterExecuteNonQuery(uv_work_t* req, int status) {
 
   self->Unref();
   delete data->cb;
+  NanDisposePersistent(data->chunk);
   
   free(data);
   free(req);
@@ -405,14 +565,252 @@ NAN_METHOD(ODBCStatement::ExecuteNonQuerySync) {
       rowCount = 0;
     }
     
-    uv_mutex_lock(&ODBC::g_odbcMutex);
+    uv_mutex_t* locked = ODBC::LockDriver(stmt->m_lock);
     SQLFreeStmt(stmt->m_hSTMT, SQL_CLOSE);
-    uv_mutex_unlock(&ODBC::g_odbcMutex);
+    ODBC::UnlockDriver(locked);
     
     NanReturnValue(NanNew<Number>(rowCount));
   }
 }
 
+/*
+ * ExecuteBatch
+ * 
+ * Execute the prepared statement once for each row of parameter values. The 
+ * rows are bound as column-wise parameter arrays so that up to 
+ * MAX_PARAMSET_SIZE of them are sent to the driver in each SQLExecute. Calls
+ * back with the number of rows affected and an array that is true for each
+ * row that succeeded.
+ * 
+ * Any parameters bound with bind() are unbound.
+ */
+
+NAN_METHOD(ODBCStatement::ExecuteBatch) {
+  DEBUG_PRINTF("ODBCStatement::ExecuteBatch\n");
+  
+  NanScope();
+  
+  if (args.Length() < 1 || !args[0]->IsArray()) {
+    return NanThrowTypeError("Argument 0 must be an Array.");
+  }
+  
+  REQ_FUN_ARG(1, cb);
+  
+  ODBCStatement* stmt = ObjectWrap::Unwrap<ODBCStatement>(args.Holder());
+  
+  Local<Array> rows = Local<Array>::Cast(args[0]);
+  int paramCount = 0;
+  const char* error = NULL;
+  
+  ParameterArray* arrays = ODBC::GetParameterArrays(rows, &paramCount, &error);
+  
+  if (arrays == NULL) {
+    return NanThrowTypeError(error);
+  }
+  
+  uv_work_t* work_req = (uv_work_t *) (calloc(1, sizeof(uv_work_t)));
+  
+  execute_batch_work_data* data = 
+    (execute_batch_work_data *) calloc(1, sizeof(execute_batch_work_data));
+  
+  data->cb = new NanCallback(cb);
+  data->stmt = stmt;
+  data->arrays = arrays;
+  data->paramCount = paramCount;
+  data->rowCount = rows->Length();
+  data->status = (SQLUSMALLINT *) malloc(data->rowCount * sizeof(SQLUSMALLINT));
+  
+  for (int row = 0; row < data->rowCount; row++) {
+    data->status[row] = SQL_PARAM_UNUSED;
+  }
+  
+  work_req->data = data;
+  
+  ODBCWorkerPool::Queue(
+    stmt->m_lock,
+    work_req,
+    UV_ExecuteBatch,
+    (uv_after_work_cb)UV_AfterExecuteBatch);
+  
+  stmt->Ref();
+  
+  NanReturnValue(NanUndefined());
+}
+
+void ODBCStatement::UV_ExecuteBatch(uv_work_t* req) {
+  DEBUG_PRINTF("ODBCStatement::UV_ExecuteBatch\n");
+  
+  execute_batch_work_data* data = (execute_batch_work_data *)(req->data);
+  
+  SQLHSTMT hSTMT = data->stmt->m_hSTMT;
+  SQLRETURN ret = SQL_SUCCESS;
+  int batchSize = (data->rowCount < MAX_PARAMSET_SIZE) 
+    ? data->rowCount 
+    : MAX_PARAMSET_SIZE;
+  
+  //drivers that do not support parameter arrays get one row at a time
+  if (batchSize > 1) {
+    ret = SQLSetStmtAttr(
+      hSTMT,
+      SQL_ATTR_PARAMSET_SIZE,
+      (SQLPOINTER) (intptr_t) batchSize,
+      0);
+    
+    if (ret == SQL_SUCCESS_WITH_INFO) {
+      //01S02: the driver substituted a paramset size of its own; use it
+      SQLULEN substituted = 0;
+      
+      ret = SQLGetStmtAttr(
+        hSTMT,
+        SQL_ATTR_PARAMSET_SIZE,
+        &substituted,
+        SQL_IS_UINTEGER,
+        NULL);
+      
+      if (SQL_SUCCEEDED(ret) && substituted >= 1 && (int) substituted <= batchSize) {
+        batchSize = (int) substituted;
+      }
+      else {
+        ret = SQL_ERROR;
+      }
+    }
+    
+    if (!SQL_SUCCEEDED(ret)) {
+      //make sure the driver is not left processing more rows per SQLExecute
+      //than we bind
+      batchSize = 1;
+      
+      SQLSetStmtAttr(hSTMT, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER) 1, 0);
+    }
+    
+    ret = SQL_SUCCESS;
+  }
+  
+  for (int offset = 0; offset < data->rowCount; offset += batchSize) {
+    int count = data->rowCount - offset;
+    
+    if (count > batchSize) {
+      count = batchSize;
+    }
+    
+    if (batchSize > 1) {
+      SQLSetStmtAttr(hSTMT, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER) (intptr_t) count, 0);
+      SQLSetStmtAttr(hSTMT, SQL_ATTR_PARAM_STATUS_PTR, &data->status[offset], 0);
+    }
+    
+    for (int i = 0; i < data->paramCount; i++) {
+      ParameterArray* array = &data->arrays[i];
+      
+      ret = SQLBindParameter(
+        hSTMT,                              //StatementHandle
+        i + 1,                              //ParameterNumber
+        SQL_PARAM_INPUT,                    //InputOutputType
+        array->ValueType,
+        array->ParameterType,
+        array->ColumnSize,
+        array->DecimalDigits,
+        array->values + (offset * array->width),
+        array->width,
+        &array->lengths[offset]);
+      
+      if (ret == SQL_ERROR) {
+        break;
+      }
+    }
+    
+    if (ret == SQL_ERROR) {
+      break;
+    }
+    
+    ret = SQLExecute(hSTMT);
+    
+    DEBUG_PRINTF("ODBCStatement::UV_ExecuteBatch - offset=%i count=%i ret=%i\n",
+                 offset, count, ret);
+    
+    if (batchSize == 1) {
+      data->status[offset] = (SQL_SUCCEEDED(ret) || ret == SQL_NO_DATA) 
+        ? SQL_PARAM_SUCCESS 
+        : SQL_PARAM_ERROR;
+    }
+    
+    if (SQL_SUCCEEDED(ret)) {
+      SQLLEN rowCount = 0;
+      
+      if (SQL_SUCCEEDED(SQLRowCount(hSTMT, &rowCount)) && rowCount > 0) {
+        data->affected += rowCount;
+      }
+    }
+    else if (ret != SQL_NO_DATA) {
+      //leave the diagnostics on the statement for UV_AfterExecuteBatch
+      break;
+    }
+  }
+  
+  data->result = ret;
+}
+
+void ODBCStatement::UV_AfterExecuteBatch(uv_work_t* req, int status) {
+  DEBUG_PRINTF("ODBCStatement::UV_AfterExecuteBatch\n");
+  
+  execute_batch_work_data* data = (execute_batch_work_data *)(req->data);
+  
+  NanScope();
+  
+  //an easy reference to the statment object
+  ODBCStatement* self = data->stmt->self();
+  
+  Local<Value> args[3];
+  
+  if (data->result == SQL_ERROR) {
+    args[0] = ODBC::GetSQLError(
+      SQL_HANDLE_STMT,
+      self->m_hSTMT,
+      (char *) "[node-odbc] Error in ODBCStatement::UV_AfterExecuteBatch");
+  }
+  else {
+    args[0] = NanNew<Value>(NanNull());
+  }
+  
+  Local<Array> rowStatus = NanNew<Array>(data->rowCount);
+  
+  for (int row = 0; row < data->rowCount; row++) {
+    rowStatus->Set(row, NanNew<Boolean>(
+      data->status[row] == SQL_PARAM_SUCCESS 
+      || data->status[row] == SQL_PARAM_SUCCESS_WITH_INFO));
+  }
+  
+  // We get a potential loss of precision here. Number isn't as big as int64. Probably fine though.
+  args[1] = NanNew<Number>(data->affected);
+  args[2] = rowStatus;
+  
+  //put the statement back the way it was for execute()
+  SQLSetStmtAttr(self->m_hSTMT, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER) 1, 0);
+  SQLSetStmtAttr(self->m_hSTMT, SQL_ATTR_PARAM_STATUS_PTR, NULL, 0);
+  
+  uv_mutex_t* locked = ODBC::LockDriver(self->m_lock);
+  SQLFreeStmt(self->m_hSTMT, SQL_CLOSE);
+  SQLFreeStmt(self->m_hSTMT, SQL_RESET_PARAMS);
+  ODBC::UnlockDriver(locked);
+  
+  self->m_paramsBound = false;
+  
+  TryCatch try_catch;
+  
+  data->cb->Call(3, args);
+  
+  if (try_catch.HasCaught()) {
+    FatalException(try_catch);
+  }
+  
+  self->Unref();
+  delete data->cb;
+  
+  ODBC::FreeParameterArrays(data->arrays, data->paramCount);
+  free(data->status);
+  free(data);
+  free(req);
+}
+
 /*
  * ExecuteDirect
  * 
@@ -448,8 +846,8 @@ NAN_METHOD(ODBCStatement::ExecuteDirect) {
   data->stmt = stmt;
   work_req->data = data;
   
-  uv_queue_work(
-    uv_default_loop(),
+  ODBCWorkerPool::Queue(
+    stmt->m_lock,
     work_req, 
     UV_ExecuteDirect, 
     (uv_after_work_cb)UV_AfterExecuteDirect);
@@ -492,15 +890,16 @@ void ODBCStatement::UV_AfterExecuteDirect(uv_work_t* req, int status) {
       data->cb);
   }
   else {
-    Local<Value> args[4];
+    Local<Value> args[5];
     bool* canFreeHandle = new bool(false);
     
     args[0] = NanNew<External>(self->m_hENV);
     args[1] = NanNew<External>(self->m_hDBC);
     args[2] = NanNew<External>(self->m_hSTMT);
     args[3] = NanNew<External>(canFreeHandle);
+    args[4] = NanNew<External>(self->m_lock);
     
-    Local<Object> js_result =  NanNew<Function>(ODBCResult::constructor)->NewInstance(4, args);
+    Local<Object> js_result =  NanNew<Function>(ODBCResult::constructor)->NewInstance(5, args);
 
     args[0] = NanNew<Value>(NanNull());
     args[1] = NanNew(js_result);
@@ -555,15 +954,16 @@ NAN_METHOD(ODBCStatement::ExecuteDirectSync) {
     NanReturnValue(NanNull());
   }
   else {
-    Local<Value> result[4];
+    Local<Value> result[5];
     bool* canFreeHandle = new bool(false);
     
     result[0] = NanNew<External>(stmt->m_hENV);
     result[1] = NanNew<External>(stmt->m_hDBC);
     result[2] = NanNew<External>(stmt->m_hSTMT);
     result[3] = NanNew<External>(canFreeHandle);
+    result[4] = NanNew<External>(stmt->m_lock);
     
-    Local<Object> js_result = NanNew<Function>(ODBCResult::constructor)->NewInstance(4, result);
+    Local<Object> js_result = NanNew<Function>(ODBCResult::constructor)->NewInstance(5, result);
     
     NanReturnValue(js_result);
   }
@@ -603,6 +1003,12 @@ NAN_METHOD(ODBCStatement::PrepareSync) {
     sqlLen);
   
   if (SQL_SUCCEEDED(ret)) {
+    SQLSMALLINT count;
+    ParameterDescription* descriptions = 
+      ODBC::DescribeParameters(stmt->m_hSTMT, &count);
+    
+    stmt->SetParameterDescriptions(descriptions, count);
+    
     NanReturnValue(NanTrue());
   }
   else {
@@ -652,8 +1058,8 @@ NAN_METHOD(ODBCStatement::Prepare) {
   
   work_req->data = data;
   
-  uv_queue_work(
-    uv_default_loop(), 
+  ODBCWorkerPool::Queue(
+    stmt->m_lock, 
     work_req, 
     UV_Prepare, 
     (uv_after_work_cb)UV_AfterPrepare);
@@ -680,6 +1086,14 @@ void ODBCStatement::UV_Prepare(uv_work_t* req) {
     data->stmt->m_hSTMT,
     (SQLTCHAR *) data->sql, 
     data->sqlLen);
+  
+  //ask for the parameter types now, while we are on the thread pool, so 
+  //that every bind can use them
+  if (SQL_SUCCEEDED(ret)) {
+    data->descriptions = ODBC::DescribeParameters(
+      data->stmt->m_hSTMT,
+      &data->descriptionCount);
+  }
 
   data->result = ret;
 }
@@ -705,6 +1119,10 @@ void ODBCStatement::UV_AfterPrepare(uv_work_t* req, int status) {
       data->cb);
   }
   else {
+    data->stmt->SetParameterDescriptions(
+      data->descriptions,
+      data->descriptionCount);
+    
     Local<Value> args[2];
 
     args[0] = NanNew<Value>(NanNull());
@@ -749,62 +1167,10 @@ NAN_METHOD(ODBCStatement::BindSync) {
     stmt->m_hSTMT
   );
   
-  //if we previously had parameters, then be sure to free them
-  //before allocating more
-  if (stmt->paramCount) {
-    int count = stmt->paramCount;
-    stmt->paramCount = 0;
-    
-    Parameter prm;
-    
-    //free parameter memory
-    for (int i = 0; i < count; i++) {
-      if (prm = stmt->params[i], prm.ParameterValuePtr != NULL) {
-        switch (prm.ValueType) {
-          case SQL_C_WCHAR:   free(prm.ParameterValuePtr);             break;
-          case SQL_C_CHAR:    free(prm.ParameterValuePtr);             break; 
-          case SQL_C_SBIGINT: delete (int64_t *)prm.ParameterValuePtr; break;
-          case SQL_C_DOUBLE:  delete (double  *)prm.ParameterValuePtr; break;
-          case SQL_C_BIT:     delete (bool    *)prm.ParameterValuePtr; break;
-        }
-      }
-    }
-
-    free(stmt->params);
-  }
-  
-  stmt->params = ODBC::GetParametersFromArray(
-    Local<Array>::Cast(args[0]), 
-    &stmt->paramCount);
-  
   SQLRETURN ret = SQL_SUCCESS;
-  Parameter prm;
   
-  for (int i = 0; i < stmt->paramCount; i++) {
-    prm = stmt->params[i];
-    
-    /*DEBUG_PRINTF(
-      "ODBCStatement::BindSync - param[%i]: c_type=%i type=%i "
-      "buffer_length=%i size=%i length=%i &length=%X decimals=%i value=%s\n",
-      i, prm.ValueType, prm.ParameterType, prm.BufferLength, prm.ColumnSize, prm.length, 
-      &stmt->params[i].StrLen_or_IndPtr, prm.DecimalDigits, prm.ParameterValuePtr
-    );*/
-
-    ret = SQLBindParameter(
-      stmt->m_hSTMT,      //StatementHandle
-      i + 1,              //ParameterNumber
-      SQL_PARAM_INPUT,    //InputOutputType
-      prm.ValueType,
-      prm.ParameterType,
-      prm.ColumnSize,
-      prm.DecimalDigits,
-      prm.ParameterValuePtr,
-      prm.BufferLength,
-      &stmt->params[i].StrLen_or_IndPtr);
-
-    if (ret == SQL_ERROR) {
-      break;
-    }
+  if (stmt->SetParameters(Local<Array>::Cast(args[0]))) {
+    ret = stmt->BindParameters();
   }
 
   if (SQL_SUCCEEDED(ret)) {
@@ -846,30 +1212,6 @@ NAN_METHOD(ODBCStatement::Bind) {
   bind_work_data* data = 
     (bind_work_data *) calloc(1, sizeof(bind_work_data));
 
-  //if we previously had parameters, then be sure to free them
-  //before allocating more
-  if (stmt->paramCount) {
-    int count = stmt->paramCount;
-    stmt->paramCount = 0;
-    
-    Parameter prm;
-    
-    //free parameter memory
-    for (int i = 0; i < count; i++) {
-      if (prm = stmt->params[i], prm.ParameterValuePtr != NULL) {
-        switch (prm.ValueType) {
-          case SQL_C_WCHAR:   free(prm.ParameterValuePtr);             break;
-          case SQL_C_CHAR:    free(prm.ParameterValuePtr);             break; 
-          case SQL_C_SBIGINT: delete (int64_t *)prm.ParameterValuePtr; break;
-          case SQL_C_DOUBLE:  delete (double  *)prm.ParameterValuePtr; break;
-          case SQL_C_BIT:     delete (bool    *)prm.ParameterValuePtr; break;
-        }
-      }
-    }
-
-    free(stmt->params);
-  }
-  
   data->stmt = stmt;
   
   DEBUG_PRINTF("ODBCStatement::Bind m_hDBC=%X m_hDBC=%X m_hSTMT=%X\n",
@@ -880,14 +1222,12 @@ NAN_METHOD(ODBCStatement::Bind) {
   
   data->cb = new NanCallback(cb);
   
-  data->stmt->params = ODBC::GetParametersFromArray(
-    Local<Array>::Cast(args[0]), 
-    &data->stmt->paramCount);
+  data->rebind = stmt->SetParameters(Local<Array>::Cast(args[0]));
   
   work_req->data = data;
   
-  uv_queue_work(
-    uv_default_loop(), 
+  ODBCWorkerPool::Queue(
+    stmt->m_lock, 
     work_req, 
     UV_Bind, 
     (uv_after_work_cb)UV_AfterBind);
@@ -909,33 +1249,9 @@ void ODBCStatement::UV_Bind(uv_work_t* req) {
   );
   
   SQLRETURN ret = SQL_SUCCESS;
-  Parameter prm;
   
-  for (int i = 0; i < data->stmt->paramCount; i++) {
-    prm = data->stmt->params[i];
-    
-    /*DEBUG_PRINTF(
-      "ODBCStatement::UV_Bind - param[%i]: c_type=%i type=%i "
-      "buffer_length=%i size=%i length=%i &length=%X decimals=%i value=%s\n",
-      i, prm.ValueType, prm.ParameterType, prm.BufferLength, prm.ColumnSize, prm.length, 
-      &data->stmt->params[i].StrLen_or_IndPtr, prm.DecimalDigits, prm.ParameterValuePtr
-    );*/
-
-    ret = SQLBindParameter(
-      data->stmt->m_hSTMT,        //StatementHandle
-      i + 1,                      //ParameterNumber
-      SQL_PARAM_INPUT,            //InputOutputType
-      prm.ValueType,
-      prm.ParameterType,
-      prm.ColumnSize,
-      prm.DecimalDigits,
-      prm.ParameterValuePtr,
-      prm.BufferLength,
-      &data->stmt->params[i].StrLen_or_IndPtr);
-
-    if (ret == SQL_ERROR) {
-      break;
-    }
+  if (data->rebind) {
+    ret = data->stmt->BindParameters();
   }
 
   data->result = ret;
@@ -980,6 +1296,340 @@ void ODBCStatement::UV_AfterBind(uv_work_t* req, int status) {
   free(req);
 }
 
+/*
+ * SetParameters
+ * 
+ * Take new parameter values. When the values can be written into the 
+ * parameters that are already bound they are written in place; otherwise
+ * new parameters are made. Returns true if any of them must be bound with
+ * BindParameters before the next execute.
+ */
+
+bool ODBCStatement::SetParameters(Local<Array> values) {
+  if (m_paramsBound 
+      && ODBC::UpdateParameters(params, paramCount, values)) {
+    for (int i = 0; i < paramCount; i++) {
+      if (params[i].rebind) {
+        return true;
+      }
+    }
+    
+    return false;
+  }
+  
+  //if we previously had parameters, then be sure to free them
+  //before allocating more
+  if (paramCount) {
+    int count = paramCount;
+    paramCount = 0;
+    
+    ODBC::FreeParameters(params, count);
+  }
+  
+  m_paramsBound = false;
+  
+  //values for a statement we could describe are bound as the types the
+  //driver gave for them
+  params = ODBC::GetParametersFromArray(
+    values, 
+    &paramCount,
+    ((int) values->Length() == m_paramDescriptionCount) 
+      ? m_paramDescriptions 
+      : NULL);
+  
+  return true;
+}
+
+/*
+ * SetParameterDescriptions
+ * 
+ * Replace the parameter types described by the driver when the statement 
+ * was prepared. Parameters bound for a previous statement are not used 
+ * again.
+ */
+
+void ODBCStatement::SetParameterDescriptions(ParameterDescription* descriptions, SQLSMALLINT count) {
+  if (m_paramDescriptions) {
+    free(m_paramDescriptions);
+  }
+  
+  m_paramDescriptions = descriptions;
+  m_paramDescriptionCount = count;
+  m_paramsBound = false;
+}
+
+/*
+ * BindParameters
+ * 
+ * Bind the statement's parameters, or only those marked with rebind if the
+ * rest are still bound. Does not touch v8, so this may be called from the 
+ * thread pool.
+ */
+
+SQLRETURN ODBCStatement::BindParameters() {
+  SQLRETURN ret = SQL_SUCCESS;
+  Parameter prm;
+  
+  for (int i = 0; i < paramCount; i++) {
+    prm = params[i];
+    
+    if (m_paramsBound && !prm.rebind) {
+      continue;
+    }
+    
+    params[i].rebind = false;
+    
+    DEBUG_PRINTF(
+      "ODBCStatement::BindParameters - param[%i]: c_type=%i type=%i "
+      "buffer_length=%i size=%i length=%i decimals=%i\n",
+      i, prm.ValueType, prm.ParameterType, prm.BufferLength, prm.ColumnSize, 
+      prm.StrLen_or_IndPtr, prm.DecimalDigits
+    );
+
+    ret = SQLBindParameter(
+      m_hSTMT,            //StatementHandle
+      i + 1,              //ParameterNumber
+      SQL_PARAM_INPUT,    //InputOutputType
+      prm.ValueType,
+      prm.ParameterType,
+      prm.ColumnSize,
+      prm.DecimalDigits,
+      prm.ParameterValuePtr,
+      prm.BufferLength,
+      &params[i].StrLen_or_IndPtr);
+
+    if (ret == SQL_ERROR) {
+      break;
+    }
+  }
+  
+  m_paramsBound = (ret != SQL_ERROR);
+  
+  return ret;
+}
+
+/*
+ * PutData
+ * 
+ * Send the next piece of the data-at-execution parameter that execute or
+ * executeNonQuery called back asking for. Calls back with just an error, if
+ * there was one. Call with null once all of the parameter has been sent;
+ * that calls back as execute or executeNonQuery would, including asking 
+ * for the next parameter if there is another.
+ */
+
+NAN_METHOD(ODBCStatement::PutData) {
+  DEBUG_PRINTF("ODBCStatement::PutData\n");
+  
+  NanScope();
+  
+  REQ_FUN_ARG(1, cb);
+  
+  ODBCStatement* stmt = ObjectWrap::Unwrap<ODBCStatement>(args.Holder());
+  
+  bool finished = args[0]->IsNull();
+  
+  if (!finished && !Buffer::HasInstance(args[0])) {
+    return NanThrowTypeError("Argument 0 must be a Buffer or null");
+  }
+  
+  uv_work_t* work_req = (uv_work_t *) (calloc(1, sizeof(uv_work_t)));
+  
+  execute_work_data* data = 
+    (execute_work_data *) calloc(1, sizeof(execute_work_data));
+
+  data->cb = new NanCallback(cb);
+  data->stmt = stmt;
+  work_req->data = data;
+  
+  if (finished) {
+    ODBCWorkerPool::Queue(
+      stmt->m_lock,
+      work_req,
+      UV_ParamData,
+      (stmt->m_executeNonQuery)
+        ? (uv_after_work_cb)UV_AfterExecuteNonQuery
+        : (uv_after_work_cb)UV_AfterExecute);
+  }
+  else {
+    Local<Object> chunk = args[0]->ToObject();
+    
+    //the chunk is sent from where it is, so hold on to it until it has been
+    NanAssignPersistent(data->chunk, chunk);
+    data->chunkData = Buffer::Data(chunk);
+    data->chunkLength = Buffer::Length(chunk);
+    
+    ODBCWorkerPool::Queue(
+      stmt->m_lock,
+      work_req,
+      UV_PutData,
+      (uv_after_work_cb)UV_AfterPutData);
+  }
+
+  stmt->Ref();
+  
+  NanReturnUndefined();
+}
+
+void ODBCStatement::UV_PutData(uv_work_t* req) {
+  DEBUG_PRINTF("ODBCStatement::UV_PutData\n");
+  
+  execute_work_data* data = (execute_work_data *)(req->data);
+  
+  data->result = SQLPutData(
+    data->stmt->m_hSTMT,
+    (SQLPOINTER) data->chunkData,
+    data->chunkLength);
+}
+
+void ODBCStatement::UV_AfterPutData(uv_work_t* req, int status) {
+  DEBUG_PRINTF("ODBCStatement::UV_AfterPutData\n");
+  
+  execute_work_data* data = (execute_work_data *)(req->data);
+  
+  NanScope();
+  
+  ODBCStatement* self = data->stmt->self();
+  
+  if (data->result == SQL_ERROR) {
+    ODBC::CallbackSQLError(
+      SQL_HANDLE_STMT,
+      self->m_hSTMT,
+      data->cb);
+  }
+  else {
+    Local<Value> args[1];
+    
+    args[0] = NanNew<Value>(NanNull());
+    
+    TryCatch try_catch;
+    
+    data->cb->Call(1, args);
+    
+    if (try_catch.HasCaught()) {
+      FatalException(try_catch);
+    }
+  }
+  
+  self->Unref();
+  delete data->cb;
+  NanDisposePersistent(data->chunk);
+  
+  free(data);
+  free(req);
+}
+
+void ODBCStatement::UV_ParamData(uv_work_t* req) {
+  DEBUG_PRINTF("ODBCStatement::UV_ParamData\n");
+  
+  execute_work_data* data = (execute_work_data *)(req->data);
+  
+  data->result = data->stmt->ParamData(&data->param);
+}
+
+/*
+ * ParamData
+ * 
+ * Once SQLExecute has returned SQL_NEED_DATA, or the whole of a 
+ * data-at-execution parameter has been sent, find out which parameter the
+ * driver wants next. When there are none left this returns the result of
+ * the execution. Does not touch v8.
+ */
+
+SQLRETURN ODBCStatement::ParamData(int* param) {
+  SQLPOINTER token = NULL;
+  
+  SQLRETURN ret = SQLParamData(m_hSTMT, &token);
+  
+  if (ret == SQL_NEED_DATA) {
+    *param = (int) ((Parameter *) token - params);
+  }
+  
+  return ret;
+}
+
+/*
+ * StartExecuteAsync
+ * 
+ * With asyncPolling, execute the statement from the main thread with 
+ * SQL_ATTR_ASYNC_ENABLE on and poll the driver until it has finished, 
+ * instead of waiting on the thread pool, then call after. Returns false,
+ * having done nothing, when that cannot be done. Statements with 
+ * data-at-execution parameters always use the thread pool.
+ */
+
+bool ODBCStatement::StartExecuteAsync(uv_work_t* req, uv_after_work_cb after) {
+  if (!m_asyncPolling) {
+    return false;
+  }
+  
+  for (int i = 0; i < paramCount; i++) {
+    if (params[i].ParameterValuePtr == &params[i]) {
+      return false;
+    }
+  }
+  
+  if (!ODBC::EnableAsync(m_hSTMT)) {
+    return false;
+  }
+  
+  execute_work_data* data = (execute_work_data *)(req->data);
+  
+  if (data->rebind) {
+    data->result = BindParameters();
+  }
+  
+  ODBC::PollAsync(req, m_hSTMT, ExecuteAsync, after);
+  
+  return true;
+}
+
+SQLRETURN ODBCStatement::ExecuteAsync(uv_work_t* req) {
+  execute_work_data* data = (execute_work_data *)(req->data);
+  
+  if (data->result != SQL_ERROR) {
+    data->result = SQLExecute(data->stmt->m_hSTMT);
+  }
+  
+  return data->result;
+}
+
+/*
+ * Cancel
+ * 
+ * Cancel the statement from the main thread. An execute, executeNonQuery or
+ * executeDirect still running on the thread pool (or being polled with
+ * asyncPolling) fails with the driver's cancellation error (SQLSTATE HY008)
+ * and an execution waiting for data-at-execution parameters is abandoned.
+ */
+
+NAN_METHOD(ODBCStatement::Cancel) {
+  DEBUG_PRINTF("ODBCStatement::Cancel\n");
+  
+  NanScope();
+
+  ODBCStatement* stmt = ObjectWrap::Unwrap<ODBCStatement>(args.Holder());
+  
+  //there is nothing to cancel once the statement has been closed
+  if (stmt->m_hSTMT == NULL) {
+    NanReturnValue(NanFalse());
+  }
+  
+  SQLRETURN ret = SQLCancel(stmt->m_hSTMT);
+  
+  if (!SQL_SUCCEEDED(ret)) {
+    NanThrowError(ODBC::GetSQLError(
+      SQL_HANDLE_STMT,
+      stmt->m_hSTMT,
+      (char *) "[node-odbc] Error in ODBCStatement::Cancel"
+    ));
+    
+    NanReturnValue(NanFalse());
+  }
+  
+  NanReturnValue(NanTrue());
+}
+
 /*
  * CloseSync
  */
@@ -1000,11 +1650,11 @@ NAN_METHOD(ODBCStatement::CloseSync) {
     stmt->Free();
   }
   else {
-    uv_mutex_lock(&ODBC::g_odbcMutex);
+    uv_mutex_t* locked = ODBC::LockDriver(stmt->m_lock);
     
     SQLFreeStmt(stmt->m_hSTMT, closeOption);
   
-    uv_mutex_unlock(&ODBC::g_odbcMutex);
+    ODBC::UnlockDriver(locked);
   }
 
   NanReturnValue(NanTrue());
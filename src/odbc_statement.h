@@ -40,6 +40,12 @@ class ODBCStatement : public node::ObjectWrap {
     //constructor
     static NAN_METHOD(New);
 
+    //Property Getter/Setters
+    static NAN_GETTER(AsyncPollingGetter);
+    static NAN_SETTER(AsyncPollingSetter);
+    static NAN_GETTER(QueryTimeoutGetter);
+    static NAN_SETTER(QueryTimeoutSetter);
+
     //async methods
     static NAN_METHOD(Execute);
     static void UV_Execute(uv_work_t* work_req);
@@ -53,6 +59,10 @@ class ODBCStatement : public node::ObjectWrap {
     static void UV_ExecuteNonQuery(uv_work_t* work_req);
     static void UV_AfterExecuteNonQuery(uv_work_t* work_req, int status);
     
+    static NAN_METHOD(ExecuteBatch);
+    static void UV_ExecuteBatch(uv_work_t* work_req);
+    static void UV_AfterExecuteBatch(uv_work_t* work_req, int status);
+    
     static NAN_METHOD(Prepare);
     static void UV_Prepare(uv_work_t* work_req);
     static void UV_AfterPrepare(uv_work_t* work_req, int status);
@@ -61,6 +71,13 @@ class ODBCStatement : public node::ObjectWrap {
     static void UV_Bind(uv_work_t* work_req);
     static void UV_AfterBind(uv_work_t* work_req, int status);
     
+    static NAN_METHOD(PutData);
+    static void UV_PutData(uv_work_t* work_req);
+    static void UV_AfterPutData(uv_work_t* work_req, int status);
+    static void UV_ParamData(uv_work_t* work_req);
+    
+    static NAN_METHOD(Cancel);
+    
     //sync methods
     static NAN_METHOD(CloseSync);
     static NAN_METHOD(ExecuteSync);
@@ -75,15 +92,31 @@ class ODBCStatement : public node::ObjectWrap {
       SQLRETURN result;
     };
     
+    bool SetParameters(Local<Array> values);
+    void SetParameterDescriptions(ParameterDescription* descriptions, SQLSMALLINT count);
+    SQLRETURN BindParameters();
+    SQLRETURN ParamData(int* param);
+    bool StartExecuteAsync(uv_work_t* req, uv_after_work_cb after);
+    static SQLRETURN ExecuteAsync(uv_work_t* req);
+    
     ODBCStatement *self(void) { return this; }
 
   protected:
     HENV m_hENV;
     HDBC m_hDBC;
     HSTMT m_hSTMT;
+    DriverLock *m_lock;
     
     Parameter *params;
     int paramCount;
+    bool m_paramsBound;
+    bool m_executeNonQuery;
+    bool m_asyncPolling;
+    SQLUINTEGER m_queryTimeout;
+    
+    //the driver's parameter types, from when the statement was prepared
+    ParameterDescription *m_paramDescriptions;
+    SQLSMALLINT m_paramDescriptionCount;
     
     uint16_t *buffer;
     int bufferLength;
@@ -103,6 +136,23 @@ struct execute_work_data {
   NanCallback* cb;
   ODBCStatement *stmt;
   int result;
+  bool rebind;
+  //the data-at-execution parameter to send next when result is SQL_NEED_DATA
+  int param;
+  Persistent<Object> chunk;
+  char *chunkData;
+  SQLLEN chunkLength;
+};
+
+struct execute_batch_work_data {
+  NanCallback* cb;
+  ODBCStatement *stmt;
+  int result;
+  ParameterArray *arrays;
+  int paramCount;
+  int rowCount;
+  SQLUSMALLINT *status;
+  SQLLEN affected;
 };
 
 struct prepare_work_data {
@@ -111,12 +161,15 @@ struct prepare_work_data {
   int result;
   void *sql;
   int sqlLen;
+  ParameterDescription *descriptions;
+  SQLSMALLINT descriptionCount;
 };
 
 struct bind_work_data {
   NanCallback* cb;
   ODBCStatement *stmt;
   int result;
+  bool rebind;
 };
 
 #endif
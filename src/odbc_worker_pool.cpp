@@ -0,0 +1,308 @@
+/*
+  Copyright (c) 2013, Dan VerWeire<dverweire@gmail.com>
+  Copyright (c) 2010, Lee Smith<notwink@gmail.com>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <string.h>
+#include <v8.h>
+#include <node.h>
+#include <node_version.h>
+#include <uv.h>
+
+#include "odbc.h"
+#include "odbc_worker_pool.h"
+
+using namespace v8;
+using namespace node;
+
+odbc_work_queue* ODBCWorkerPool::g_pool = NULL;
+uv_async_t ODBCWorkerPool::g_completed;
+uv_mutex_t ODBCWorkerPool::g_completedMutex;
+odbc_work_item* ODBCWorkerPool::g_completedHead = NULL;
+odbc_work_item* ODBCWorkerPool::g_completedTail = NULL;
+int ODBCWorkerPool::g_pending = 0;
+
+void ODBCWorkerPool::Init(v8::Handle<Object> exports) {
+  DEBUG_PRINTF("ODBCWorkerPool::Init\n");
+  NanScope();
+
+  uv_mutex_init(&g_completedMutex);
+
+  //finished work is handed back to the event loop through g_completed. It
+  //only keeps the loop alive while there is work outstanding.
+  uv_async_init(uv_default_loop(), &g_completed, UV_Completed);
+  uv_unref((uv_handle_t *) &g_completed);
+
+  exports->Set(NanNew("setWorkerThreads"),
+        NanNew<FunctionTemplate>(SetWorkerThreads)->GetFunction());
+  exports->Set(NanNew("getWorkerThreads"),
+        NanNew<FunctionTemplate>(GetWorkerThreads)->GetFunction());
+}
+
+/*
+ * Queue
+ *
+ * Queue work the way uv_queue_work does: work is called on another thread
+ * and after is called on the event loop once it is done. Work for a
+ * connection with a pinned worker goes to that worker's thread, other work
+ * goes to the shared pool if there is one and to libuv's pool if not.
+ */
+
+int ODBCWorkerPool::Queue(DriverLock* lock, uv_work_t* req, uv_work_cb work, uv_after_work_cb after) {
+  odbc_work_queue* queue = (lock && lock->worker) ? lock->worker : g_pool;
+
+  if (queue == NULL) {
+    return uv_queue_work(uv_default_loop(), req, work, after);
+  }
+
+  odbc_work_item* item = (odbc_work_item *) malloc(sizeof(odbc_work_item));
+
+  item->req = req;
+  item->work = work;
+  item->after = after;
+  item->queue = NULL;
+  item->next = NULL;
+
+  if (g_pending++ == 0) {
+    uv_ref((uv_handle_t *) &g_completed);
+  }
+
+  uv_mutex_lock(&queue->mutex);
+
+  if (queue->tail) {
+    queue->tail->next = item;
+  }
+  else {
+    queue->head = item;
+  }
+
+  queue->tail = item;
+
+  uv_cond_signal(&queue->cond);
+  uv_mutex_unlock(&queue->mutex);
+
+  return 0;
+}
+
+/*
+ * CreateQueue
+ */
+
+odbc_work_queue* ODBCWorkerPool::CreateQueue(int threadCount) {
+  DEBUG_PRINTF("ODBCWorkerPool::CreateQueue threadCount=%i\n", threadCount);
+
+  odbc_work_queue* queue = (odbc_work_queue *) calloc(1, sizeof(odbc_work_queue));
+
+  uv_mutex_init(&queue->mutex);
+  uv_cond_init(&queue->cond);
+
+  AddThreads(queue, threadCount);
+
+  return queue;
+}
+
+void ODBCWorkerPool::AddThreads(odbc_work_queue* queue, int threadCount) {
+  queue->threads = (uv_thread_t *) realloc(
+    queue->threads,
+    (queue->threadCount + threadCount) * sizeof(uv_thread_t));
+
+  for (int i = 0; i < threadCount; i++) {
+    queue->running++;
+
+    uv_thread_create(&queue->threads[queue->threadCount++], Work, queue);
+  }
+}
+
+/*
+ * DestroyQueue
+ *
+ * Tell the queue's threads to stop once they have finished what has been
+ * queued. This does not wait for them: that could mean waiting for a long
+ * query. The last one to stop hands the queue back to the event loop, which
+ * joins the threads and frees it.
+ */
+
+void ODBCWorkerPool::DestroyQueue(odbc_work_queue* queue) {
+  DEBUG_PRINTF("ODBCWorkerPool::DestroyQueue\n");
+
+  uv_mutex_lock(&queue->mutex);
+  queue->stopping = true;
+  uv_cond_broadcast(&queue->cond);
+  uv_mutex_unlock(&queue->mutex);
+}
+
+void ODBCWorkerPool::FreeQueue(odbc_work_queue* queue) {
+  DEBUG_PRINTF("ODBCWorkerPool::FreeQueue\n");
+
+  //every thread has left Work, or is just about to
+  for (int i = 0; i < queue->threadCount; i++) {
+    uv_thread_join(&queue->threads[i]);
+  }
+
+  uv_cond_destroy(&queue->cond);
+  uv_mutex_destroy(&queue->mutex);
+
+  free(queue->threads);
+  free(queue);
+}
+
+/*
+ * Work
+ *
+ * The body of each of our threads.
+ */
+
+void ODBCWorkerPool::Work(void* arg) {
+  odbc_work_queue* queue = (odbc_work_queue *) arg;
+
+  for (;;) {
+    uv_mutex_lock(&queue->mutex);
+
+    while (queue->head == NULL && !queue->stopping) {
+      uv_cond_wait(&queue->cond, &queue->mutex);
+    }
+
+    odbc_work_item* item = queue->head;
+
+    if (item == NULL) {
+      //stopping and there is nothing left to do
+      bool last = (--queue->running == 0);
+
+      uv_mutex_unlock(&queue->mutex);
+
+      if (last) {
+        odbc_work_item* reap = (odbc_work_item *) calloc(1, sizeof(odbc_work_item));
+
+        reap->queue = queue;
+
+        Complete(reap);
+      }
+
+      return;
+    }
+
+    queue->head = item->next;
+
+    if (queue->head == NULL) {
+      queue->tail = NULL;
+    }
+
+    uv_mutex_unlock(&queue->mutex);
+
+    item->work(item->req);
+
+    Complete(item);
+  }
+}
+
+void ODBCWorkerPool::Complete(odbc_work_item* item) {
+  item->next = NULL;
+
+  uv_mutex_lock(&g_completedMutex);
+
+  if (g_completedTail) {
+    g_completedTail->next = item;
+  }
+  else {
+    g_completedHead = item;
+  }
+
+  g_completedTail = item;
+
+  uv_mutex_unlock(&g_completedMutex);
+
+  uv_async_send(&g_completed);
+}
+
+/*
+ * UV_Completed
+ *
+ * Call the after callback of everything that has finished. uv_async_send
+ * calls may be coalesced, so there can be any number of them.
+ */
+
+#if UV_VERSION_MAJOR >= 1
+void ODBCWorkerPool::UV_Completed(uv_async_t* async) {
+#else
+void ODBCWorkerPool::UV_Completed(uv_async_t* async, int status) {
+#endif
+  uv_mutex_lock(&g_completedMutex);
+
+  odbc_work_item* item = g_completedHead;
+  g_completedHead = NULL;
+  g_completedTail = NULL;
+
+  uv_mutex_unlock(&g_completedMutex);
+
+  while (item) {
+    odbc_work_item* next = item->next;
+    uv_work_t* req = item->req;
+    uv_after_work_cb after = item->after;
+
+    if (item->queue) {
+      FreeQueue(item->queue);
+      free(item);
+
+      item = next;
+      continue;
+    }
+
+    free(item);
+
+    g_pending--;
+
+    //after may queue more work with the same req
+    after(req, 0);
+
+    item = next;
+  }
+
+  if (g_pending == 0) {
+    uv_unref((uv_handle_t *) &g_completed);
+  }
+}
+
+/*
+ * SetWorkerThreads
+ *
+ * Start the shared pool with the given number of threads, or add threads
+ * to it. Threads are never taken away. Returns the number of threads.
+ */
+
+NAN_METHOD(ODBCWorkerPool::SetWorkerThreads) {
+  DEBUG_PRINTF("ODBCWorkerPool::SetWorkerThreads\n");
+  NanScope();
+
+  if (!args[0]->IsInt32() || args[0]->Int32Value() < 1) {
+    return NanThrowTypeError("setWorkerThreads(): Argument 0 must be a positive integer.");
+  }
+
+  int threadCount = args[0]->Int32Value();
+
+  if (g_pool == NULL) {
+    g_pool = CreateQueue(threadCount);
+  }
+  else if (threadCount > g_pool->threadCount) {
+    AddThreads(g_pool, threadCount - g_pool->threadCount);
+  }
+
+  NanReturnValue(NanNew<Number>(g_pool->threadCount));
+}
+
+NAN_METHOD(ODBCWorkerPool::GetWorkerThreads) {
+  NanScope();
+
+  NanReturnValue(NanNew<Number>((g_pool) ? g_pool->threadCount : 0));
+}
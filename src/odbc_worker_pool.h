@@ -0,0 +1,83 @@
+/*
+  Copyright (c) 2013, Dan VerWeire<dverweire@gmail.com>
+  Copyright (c) 2010, Lee Smith<notwink@gmail.com>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#ifndef _SRC_ODBC_WORKER_POOL_H
+#define _SRC_ODBC_WORKER_POOL_H
+
+#include <uv.h>
+
+struct odbc_work_queue;
+
+//one piece of work waiting for, or finished by, one of our threads. An item
+//with a queue instead of work tells the event loop that queue's threads
+//have stopped and can be joined.
+struct odbc_work_item {
+  uv_work_t *req;
+  uv_work_cb work;
+  uv_after_work_cb after;
+  odbc_work_queue *queue;
+  odbc_work_item *next;
+};
+
+//work served by threads of our own, in the order it was queued. The
+//shared pool has many threads; a connection's pinned queue has one.
+struct odbc_work_queue {
+  uv_mutex_t mutex;
+  uv_cond_t cond;
+  odbc_work_item *head;
+  odbc_work_item *tail;
+  uv_thread_t *threads;
+  int threadCount;
+  int running;
+  bool stopping;
+};
+
+class ODBCWorkerPool {
+  public:
+    static void Init(v8::Handle<v8::Object> exports);
+
+    static int Queue(DriverLock* lock, uv_work_t* req, uv_work_cb work, uv_after_work_cb after);
+    static odbc_work_queue* CreateQueue(int threadCount);
+    static void DestroyQueue(odbc_work_queue* queue);
+
+    static NAN_METHOD(SetWorkerThreads);
+    static NAN_METHOD(GetWorkerThreads);
+
+  protected:
+    static void AddThreads(odbc_work_queue* queue, int threadCount);
+    static void Work(void* arg);
+    static void Complete(odbc_work_item* item);
+    static void FreeQueue(odbc_work_queue* queue);
+#if UV_VERSION_MAJOR >= 1
+    static void UV_Completed(uv_async_t* async);
+#else
+    static void UV_Completed(uv_async_t* async, int status);
+#endif
+
+    //the shared pool; NULL until setWorkerThreads is called, in which case
+    //work goes to libuv's pool
+    static odbc_work_queue* g_pool;
+
+    //finished work waiting to be handed back to the event loop
+    static uv_async_t g_completed;
+    static uv_mutex_t g_completedMutex;
+    static odbc_work_item* g_completedHead;
+    static odbc_work_item* g_completedTail;
+    static int g_pending;
+};
+
+#endif
@@ -0,0 +1,44 @@
+var common = require("./common")
+  , odbc = require("../")
+  , db = new odbc.Database()
+  , dbGlobal = new odbc.Database({ lockMode : odbc.LOCK_GLOBAL })
+  , assert = require("assert")
+  ;
+
+db.openSync(common.connectionString);
+dbGlobal.openSync(common.connectionString);
+
+assert.equal(db.conn.lockMode, odbc.LOCK_CONNECTION);
+assert.equal(dbGlobal.conn.lockMode, odbc.LOCK_GLOBAL);
+
+//the mode can not be changed once the connection is open
+assert.throws(function () {
+  db.conn.lockMode = odbc.LOCK_NONE;
+});
+assert.equal(db.conn.lockMode, odbc.LOCK_CONNECTION);
+
+//an unknown mode is ignored
+var unopened = new odbc.ODBC().createConnectionSync();
+
+unopened.lockMode = 42;
+assert.equal(unopened.lockMode, odbc.LOCK_CONNECTION);
+
+var acquisitions = db.conn.lockAcquisitions;
+
+db.query("select 1 as COLINT", function (err, data) {
+  assert.equal(err, null);
+  assert.deepEqual(data, [{ COLINT : 1 }]);
+  
+  dbGlobal.query("select 2 as COLINT", function (err, data) {
+    assert.equal(err, null);
+    assert.deepEqual(data, [{ COLINT : 2 }]);
+    
+    assert.ok(db.conn.lockAcquisitions > acquisitions);
+    assert.ok(dbGlobal.conn.lockAcquisitions > 0);
+    assert.ok(db.conn.lockContentions <= db.conn.lockAcquisitions);
+    
+    db.closeSync();
+    dbGlobal.closeSync();
+    console.log("connection closed");
+  });
+});
@@ -0,0 +1,33 @@
+var common = require("./common")
+  , odbc = require("../")
+  , assert = require("assert")
+  , modes = [odbc.LOCK_CONNECTION, odbc.LOCK_GLOBAL, odbc.LOCK_NONE]
+  , openCount = 10
+  , remaining = modes.length * openCount
+  ;
+
+//connections are opened at the same time; only LOCK_GLOBAL makes them wait
+//for each other
+modes.forEach(function (mode) {
+  for (var x = 0; x < openCount; x++) {
+    (function () {
+      var db = new odbc.Database({ lockMode : mode });
+      
+      db.open(common.connectionString, function (err) {
+        assert.equal(err, null);
+        assert.equal(db.conn.lockMode, mode);
+        
+        db.query("select 1 as COLINT", function (err, data) {
+          assert.equal(err, null);
+          assert.deepEqual(data, [{ COLINT : 1 }]);
+          
+          db.close(function () {
+            if (--remaining === 0) {
+              console.log("Done");
+            }
+          });
+        });
+      });
+    })();
+  }
+});
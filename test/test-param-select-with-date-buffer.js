@@ -0,0 +1,21 @@
+var common = require("./common")
+  , odbc = require("../")
+  , db = new odbc.Database()
+  , assert = require("assert")
+  , dt = new Date()
+  , blob = new Buffer([1, 2, 255])
+  ;
+
+db.openSync(common.connectionString);
+
+db.query("select cast(? as datetime) as \"DT1\", cast(? as blob) as \"BIN1\" "
+  , [dt, blob]
+  , function (err, data, more) {
+      db.closeSync();
+      
+      assert.equal(err, null);
+      assert.equal(data[0].DT1.constructor.name, "Date", "DT1 is not an instance of a Date object");
+      assert.equal(data[0].DT1.getTime(), dt.getTime());
+      assert.ok(Buffer.isBuffer(data[0].BIN1));
+      assert.equal(data[0].BIN1.toString('hex'), '0102ff');
+  });
@@ -0,0 +1,39 @@
+var common = require("./common")
+  , odbc = require("../")
+  , db = new odbc.Database()
+  , assert = require("assert");
+
+db.openSync(common.connectionString);
+
+db.query("select ? as \"INTCOL1\", ? as \"TEXTCOL1\", ? as \"NULLCOL1\" "
+  , [
+      { value : 5, type : odbc.SQL_INTEGER }
+    , { value : "fish", type : odbc.SQL_VARCHAR, size : 10 }
+    , { value : null, type : odbc.SQL_INTEGER }
+  ]
+  , function (err, data, more) {
+      assert.equal(err, null);
+      assert.deepEqual(data, [{
+        INTCOL1 : 5
+        , TEXTCOL1 : "fish"
+        , NULLCOL1 : null
+      }]);
+      
+      var stmt = db.prepareSync("select ? as \"INTCOL1\"");
+      
+      stmt.execute([{ value : 6, type : odbc.SQL_INTEGER }], function (err, result) {
+        assert.equal(err, null);
+        assert.deepEqual(result.fetchAllSync(), [{ INTCOL1 : 6 }]);
+        result.closeSync();
+        
+        //keeps the type it was bound with
+        stmt.execute([7], function (err, result) {
+          assert.equal(err, null);
+          assert.deepEqual(result.fetchAllSync(), [{ INTCOL1 : 7 }]);
+          result.closeSync();
+          
+          db.closeSync();
+          console.log("connection closed");
+        });
+      });
+  });
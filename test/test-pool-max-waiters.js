@@ -0,0 +1,67 @@
+var common = require("./common")
+  , odbc = require("../")
+  , assert = require("assert")
+  , pool = new odbc.Pool({ max : 2, acquireTimeout : 5000 })
+  , connectionString = common.connectionString
+  , openCount = 6
+  , remaining = openCount
+  , inUse = 0
+  , seen = []
+  ;
+
+//only two connections are ever opened; everyone else waits for one of them
+//to be returned, and gets it back without reconnecting
+for (var x = 0; x < openCount; x++) {
+  pool.open(connectionString, function (err, db) {
+    assert.equal(err, null);
+    
+    inUse += 1;
+    assert.ok(inUse <= 2);
+    
+    if (seen.indexOf(db) === -1) {
+      seen.push(db);
+    }
+    
+    db.beginTransaction(function (err) {
+      assert.equal(err, null);
+      
+      db.query("select 1 as COLINT", function (err, data) {
+        assert.equal(err, null);
+        assert.deepEqual(data, [{ COLINT : 1 }]);
+        
+        inUse -= 1;
+        
+        //the open transaction is rolled back before it is handed out again
+        db.close(function (err) {
+          assert.equal(err, null);
+          
+          if (--remaining === 0) {
+            assert.equal(seen.length, 2);
+            
+            testTimeout();
+          }
+        });
+      });
+    });
+  });
+}
+
+function testTimeout() {
+  var small = new odbc.Pool({ max : 1, acquireTimeout : 100 });
+  
+  small.open(connectionString, function (err, db) {
+    assert.equal(err, null);
+    
+    small.open(connectionString, function (err, db2) {
+      assert.ok(err);
+      assert.ok(/Timed out/.test(err.message));
+      assert.equal(db2, undefined);
+      
+      small.close(function () {
+        pool.close(function () {
+          console.log("Done");
+        });
+      });
+    });
+  });
+}
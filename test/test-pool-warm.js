@@ -0,0 +1,82 @@
+var common = require("./common")
+  , odbc = require("../")
+  , assert = require("assert")
+  , connectionString = common.connectionString
+  , pool = new odbc.Pool({ minIdle : 2, max : 4 })
+  ;
+
+//without a count, minIdle connections are opened
+pool.warm(connectionString, function (err) {
+  assert.equal(err, null);
+  assert.equal(pool._group(connectionString).available.length, 2);
+  
+  //more than max are not opened
+  pool.warm(connectionString, 10, function (err) {
+    assert.equal(err, null);
+    assert.equal(pool._group(connectionString).available.length, 4);
+    
+    testReplenish();
+  });
+});
+
+//a pool that is kept topped up with idle connections as they are handed out
+function testReplenish() {
+  var topped = new odbc.Pool({ minIdle : 2 })
+    , group = topped._group(connectionString)
+    ;
+  
+  topped.warm(connectionString, function (err) {
+    assert.equal(err, null);
+    assert.equal(group.available.length, 2);
+    
+    topped.open(connectionString, function (err, db) {
+      assert.equal(err, null);
+      
+      //one was handed out; another is already being opened to replace it
+      assert.equal(group.available.length + group.warming, 2);
+      
+      var timer = setInterval(function () {
+        if (group.warming) {
+          return;
+        }
+        
+        clearInterval(timer);
+        
+        assert.equal(group.available.length, 2);
+        assert.equal(group.used.length, 1);
+        
+        topped.close(function () {
+          testMin();
+        });
+      }, 10);
+    });
+  });
+}
+
+//a pool that opens connections in the background until min are open
+function testMin() {
+  var kept = new odbc.Pool({ min : 3 })
+    , group = kept._group(connectionString)
+    ;
+  
+  kept.open(connectionString, function (err, db) {
+    assert.equal(err, null);
+    
+    var timer = setInterval(function () {
+      if (group.warming) {
+        return;
+      }
+      
+      clearInterval(timer);
+      
+      assert.equal(kept._size(group), 3);
+      assert.equal(group.used.length, 1);
+      
+      kept.close(function () {
+        pool.close(function () {
+          console.log("Done");
+        });
+      });
+    }, 10);
+  });
+}
@@ -0,0 +1,52 @@
+var common = require("./common")
+  , odbc = require("../")
+  , db = new odbc.Database()
+  , assert = require("assert")
+  , values = [
+      [1, 'a', 1.5]
+    , [2, 'a much longer string than before', 2]
+    , [3, null, null]
+    , ['4', 'd', 4.25]
+  ]
+  ;
+
+db.openSync(common.connectionString);
+
+db.querySync("create table described_params (COLINT INTEGER, COLTEXT VARCHAR(50), COLNUM DECIMAL(10, 2))");
+
+//the statement is described by the driver when it is prepared; every value
+//bound to it should still arrive as it was given
+db.prepare("insert into described_params (COLINT, COLTEXT, COLNUM) VALUES (?, ?, ?)", function (err, stmt) {
+  assert.equal(err, null);
+  
+  issueInsert(0);
+  
+  function issueInsert(index) {
+    if (index >= values.length) {
+      return checkRows();
+    }
+    
+    stmt.executeNonQuery(values[index], function (err, count) {
+      assert.equal(err, null);
+      assert.equal(count, 1);
+      
+      issueInsert(index + 1);
+    });
+  }
+});
+
+function checkRows() {
+  var data = db.querySync("select COLINT, COLTEXT, COLNUM from described_params order by COLINT");
+  
+  db.querySync("drop table described_params");
+  
+  assert.deepEqual(data, [
+      { COLINT : 1, COLTEXT : 'a', COLNUM : 1.5 }
+    , { COLINT : 2, COLTEXT : 'a much longer string than before', COLNUM : 2 }
+    , { COLINT : 3, COLTEXT : null, COLNUM : null }
+    , { COLINT : 4, COLTEXT : 'd', COLNUM : 4.25 }
+  ]);
+  
+  db.closeSync();
+  console.log("connection closed");
+}
@@ -0,0 +1,50 @@
+var common = require("./common")
+  , odbc = require("../")
+  , db = new odbc.Database()
+  , assert = require("assert")
+  , stream = require("stream")
+  , chunks = []
+  ;
+
+for (var x = 0; x < 10; x++) {
+  var chunk = new Buffer(10000);
+  chunk.fill(x);
+  chunks.push(chunk);
+}
+
+var expected = Buffer.concat(chunks);
+
+db.openSync(common.connectionString);
+
+var stmt = db.prepareSync("select cast(? as blob) as BIN1, ? as TEXT1");
+
+stmt.execute([chunks, { value : ['fi', 'sh'].map(function (s) { return new Buffer(s) }), type : odbc.SQL_LONGVARCHAR }], function (err, result) {
+  assert.equal(err, null);
+  
+  var data = result.fetchAllSync();
+  result.closeSync();
+  
+  assert.equal(data[0].BIN1.toString('hex'), expected.toString('hex'));
+  assert.equal(data[0].TEXT1, 'fish');
+  
+  var readable = new stream.PassThrough();
+  
+  stmt.execute([readable, 'plain'], function (err, result) {
+    assert.equal(err, null);
+    
+    var data = result.fetchAllSync();
+    result.closeSync();
+    
+    assert.equal(data[0].BIN1.toString('hex'), expected.toString('hex'));
+    assert.equal(data[0].TEXT1, 'plain');
+    
+    db.closeSync();
+    console.log("connection closed");
+  });
+  
+  chunks.forEach(function (chunk) {
+    readable.write(chunk);
+  });
+  
+  readable.end();
+});
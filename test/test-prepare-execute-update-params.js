@@ -0,0 +1,44 @@
+var common = require("./common")
+  , odbc = require("../")
+  , db = new odbc.Database()
+  , assert = require("assert")
+  , values = [
+      [1, 'a', true]
+    , [2, 'bb', false]
+    , [3, 'a much longer string than before', true]
+    , [null, null, null]
+    , [4.5, 'c', true]
+    , ['five', 'd', false]
+    , [6, 'e', true]
+      //outgrows the buffer that was made with room to spare
+    , [7, new Array(301).join('g'), false]
+    , [8, 'h', true]
+  ]
+  ;
+
+db.openSync(common.connectionString);
+
+var stmt = db.prepareSync("select ? as COLA, ? as COLB, ? as COLC");
+
+issueQuery(0);
+
+function issueQuery(index) {
+  if (index >= values.length) {
+    db.closeSync();
+    console.log("connection closed");
+    return;
+  }
+  
+  stmt.execute(values[index], function (err, result) {
+    assert.equal(err, null);
+    
+    var data = result.fetchAllSync({ fetchMode : odbc.FETCH_ARRAY });
+    
+    result.closeSync();
+    
+    assert.equal(data[0][0], values[index][0]);
+    assert.equal(data[0][1], values[index][1]);
+    
+    issueQuery(index + 1);
+  });
+}
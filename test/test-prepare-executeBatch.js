@@ -0,0 +1,70 @@
+var common = require("./common")
+  , odbc = require("../")
+  , db = new odbc.Database()
+  , assert = require("assert")
+  , rows = []
+  ;
+
+for (var x = 0; x < 2500; x++) {
+  rows.push([x, (x % 3) ? 'row ' + x : null]);
+}
+
+db.openSync(common.connectionString);
+
+common.dropTables(db, function () {
+  common.createTables(db, function (err) {
+    assert.equal(err, null);
+    
+    var stmt = db.prepareSync("insert into " + common.tableName + " (COLINT, COLTEXT) values (?, ?)");
+    
+    stmt.executeBatch(rows, function (err, count, status) {
+      assert.equal(err, null);
+      assert.equal(count, rows.length);
+      assert.equal(status.length, rows.length);
+      assert.ok(status.every(function (ok) { return ok; }));
+      
+      var data = db.querySync("select COLINT, COLTEXT from " + common.tableName + " order by COLINT");
+      
+      assert.equal(data.length, rows.length);
+      assert.deepEqual(data[2], { COLINT : 2, COLTEXT : 'row 2' });
+      assert.deepEqual(data[3], { COLINT : 3, COLTEXT : null });
+      
+      testDates(db);
+    });
+  });
+});
+
+//Dates are bound as timestamps, not as the strings Date#toString gives
+function testDates(db) {
+  var stmt = db.prepareSync("insert into " + common.tableName + " (COLINT, COLDATETIME) values (?, ?)")
+    , date = new Date(2014, 1, 3, 4, 5, 6)
+    ;
+  
+  //a Date can only be mixed with nulls
+  assert.throws(function () {
+    stmt.executeBatch([[1, date], [2, 'tomorrow']], function () {});
+  }, TypeError);
+  
+  stmt.executeBatch([[-1, date], [-2, null]], function (err, count) {
+    assert.equal(err, null);
+    assert.equal(count, 2);
+    
+    var data = db.querySync("select COLINT, COLDATETIME from " + common.tableName + " where COLINT < 0 order by COLINT desc");
+    
+    assert.equal(data.length, 2);
+    
+    //some drivers give DATETIME columns back as strings
+    var value = data[0].COLDATETIME;
+    
+    assert.ok((value instanceof Date)
+      ? value.getTime() == date.getTime()
+      : /^2014-02-03 04:05:06/.test(value));
+    
+    assert.equal(data[1].COLDATETIME, null);
+    
+    common.dropTables(db, function () {
+      db.closeSync();
+      console.log("connection closed");
+    });
+  });
+}
@@ -0,0 +1,27 @@
+var common = require("./common")
+  , odbc = require("../")
+  , db = new odbc.Database()
+  , assert = require("assert")
+  ;
+
+db.openSync(common.connectionString);
+assert.equal(db.connected, true);
+
+db.conn.queryAll("select 1 as COLINT, 'fish' as COLTEXT union all select 2, 'scarf'", function (err, sets) {
+  assert.equal(err, null);
+  assert.equal(sets.length, 1);
+  assert.deepEqual(sets[0], [{ COLINT : 1, COLTEXT : 'fish' }, { COLINT : 2, COLTEXT : 'scarf' }]);
+  
+  db.conn.queryAll({ sql : "select ? as COLINT", params : [42], fetchMode : odbc.FETCH_ARRAY }, function (err, sets) {
+    assert.equal(err, null);
+    assert.deepEqual(sets[0], [[42]]);
+    
+    db.conn.queryAll("select invalid query", function (err, sets) {
+      assert.ok(err);
+      assert.equal(sets.length, 0);
+      
+      db.closeSync();
+      console.log("connection closed");
+    });
+  });
+});
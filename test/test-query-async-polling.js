@@ -0,0 +1,31 @@
+var common = require("./common")
+  , odbc = require("../")
+  , db = new odbc.Database({ asyncPolling : true })
+  , assert = require("assert")
+  ;
+
+db.openSync(common.connectionString);
+assert.equal(db.conn.asyncPolling, true);
+
+db.query("select ? as COLINT, 'fish' as COLTEXT", [1], function (err, data) {
+  assert.equal(err, null);
+  assert.deepEqual(data, [{ COLINT : 1, COLTEXT : 'fish' }]);
+  
+  db.prepare("select ? as COLINT", function (err, stmt) {
+    assert.equal(err, null);
+    assert.equal(stmt.asyncPolling, true);
+    
+    stmt.execute([2], function (err, result) {
+      assert.equal(err, null);
+      assert.deepEqual(result.fetchAllSync(), [{ COLINT : 2 }]);
+      result.closeSync();
+      
+      db.query("select invalid query", function (err, data) {
+        assert.ok(err);
+        
+        db.closeSync();
+        console.log("connection closed");
+      });
+    });
+  });
+});
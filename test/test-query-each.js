@@ -0,0 +1,32 @@
+var common = require("./common")
+  , odbc = require("../")
+  , db = new odbc.Database({ fetchSize : 4 })
+  , assert = require("assert")
+  , batches = []
+  ;
+
+db.openSync(common.connectionString);
+assert.equal(db.connected, true);
+
+db.queryEach("select 1 as COLINT union all select 2 union all select 3 "
+  + "union all select 4 union all select 5 union all select 6", function (rows) {
+  assert.ok(rows.length <= 4);
+  batches.push(rows);
+}, function (err, count) {
+  assert.equal(err, null);
+  assert.equal(count, 6);
+  assert.equal(batches.length, 2);
+  assert.deepEqual(batches[0].concat(batches[1]).map(function (row) { return row.COLINT; }), [1, 2, 3, 4, 5, 6]);
+  
+  //returning false stops the fetch after the first batch
+  db.queryEach("select 1 as COLINT union all select 2 union all select 3 "
+    + "union all select 4 union all select 5 union all select 6", function (rows) {
+    return false;
+  }, function (err, count) {
+    assert.equal(err, null);
+    assert.equal(count, 4);
+    
+    db.closeSync();
+    console.log("connection closed");
+  });
+});
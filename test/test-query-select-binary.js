@@ -0,0 +1,27 @@
+var common = require("./common")
+  , odbc = require("../")
+  , db = new odbc.Database()
+  , assert = require("assert")
+  , blob = new Buffer(20000)
+  ;
+
+for (var x = 0; x < blob.length; x++) {
+  blob[x] = x % 256;
+}
+
+db.openSync(common.connectionString);
+assert.equal(db.connected, true);
+
+db.query("select x'0102ff' as COLBIN, x'" + blob.toString('hex') + "' as COLBLOB", function (err, data) {
+  assert.equal(err, null);
+  
+  assert.ok(Buffer.isBuffer(data[0].COLBIN));
+  assert.equal(data[0].COLBIN.toString('hex'), '0102ff');
+  
+  assert.ok(Buffer.isBuffer(data[0].COLBLOB));
+  assert.equal(data[0].COLBLOB.length, blob.length);
+  assert.equal(data[0].COLBLOB.toString('hex'), blob.toString('hex'));
+  
+  db.closeSync();
+  console.log("connection closed");
+});
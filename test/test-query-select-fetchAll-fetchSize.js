@@ -0,0 +1,30 @@
+var common = require("./common")
+  , odbc = require("../")
+  , db = new odbc.Database({ fetchSize : 2 })
+  , assert = require("assert")
+  ;
+
+db.openSync(common.connectionString);
+
+assert.equal(db.connected, true);
+
+db.querySync("create table " + common.tableName + "_FETCHSIZE (COLINT INTEGER, COLTEXT VARCHAR(20))");
+db.querySync("insert into " + common.tableName + "_FETCHSIZE values (1, 'one')");
+db.querySync("insert into " + common.tableName + "_FETCHSIZE values (2, 'two')");
+db.querySync("insert into " + common.tableName + "_FETCHSIZE values (3, null)");
+db.querySync("insert into " + common.tableName + "_FETCHSIZE values (null, 'four')");
+db.querySync("insert into " + common.tableName + "_FETCHSIZE values (5, 'five')");
+
+db.query("select * from " + common.tableName + "_FETCHSIZE order by COLINT is null, COLINT", function (err, data) {
+  db.querySync("drop table " + common.tableName + "_FETCHSIZE");
+  db.closeSync();
+  
+  assert.equal(err, null);
+  assert.deepEqual(data, [
+      { COLINT : 1, COLTEXT : "one" }
+    , { COLINT : 2, COLTEXT : "two" }
+    , { COLINT : 3, COLTEXT : null }
+    , { COLINT : 5, COLTEXT : "five" }
+    , { COLINT : null, COLTEXT : "four" }
+  ]);
+});
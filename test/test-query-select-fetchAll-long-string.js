@@ -0,0 +1,42 @@
+var common = require("./common")
+  , odbc = require("../")
+  , db = new odbc.Database()
+  , assert = require("assert")
+  , lengths = [100001, 3000, 4000, 5000, 8000]
+  ;
+
+db.openSync(common.connectionString);
+assert.equal(db.connected, true);
+
+issueQuery(0);
+
+function issueQuery(index) {
+  if (index >= lengths.length) {
+    return finish(0);
+  }
+  
+  var str = ''
+    , set = 'abcdefghijklmnopqrstuvwxyz'
+    ;
+  
+  for (var x = 0; x < lengths[index]; x++) {
+    str += set[x % set.length];
+  }
+  
+  db.query('select ? as longString', [str], function (err, data) {
+    assert.equal(err, null);
+    
+    console.log('expected length: %s, returned length: %s', str.length, data[0].longString.length);
+    
+    assert.equal(data[0].longString, str);
+    
+    issueQuery(index + 1);
+  });
+}
+
+function finish(exitCode) {
+  db.closeSync();
+  
+  console.log("connection closed");
+  process.exit(exitCode || 0);
+}
@@ -0,0 +1,29 @@
+var common = require("./common")
+  , odbc = require("../")
+  , db = new odbc.Database({ fetchMode : odbc.FETCH_COLUMNS })
+  , assert = require("assert")
+  ;
+
+db.openSync(common.connectionString);
+
+assert.equal(db.connected, true);
+
+db.querySync("create table " + common.tableName + "_COLUMNS (COLINT INTEGER, COLDOUBLE DOUBLE, COLTEXT VARCHAR(20))");
+db.querySync("insert into " + common.tableName + "_COLUMNS values (1, 1.5, 'one')");
+db.querySync("insert into " + common.tableName + "_COLUMNS values (2, null, 'two')");
+db.querySync("insert into " + common.tableName + "_COLUMNS values (null, 3.5, null)");
+
+db.query("select * from " + common.tableName + "_COLUMNS order by COLINT is null, COLINT", function (err, data) {
+  db.querySync("drop table " + common.tableName + "_COLUMNS");
+  db.closeSync();
+  
+  assert.equal(err, null);
+  
+  assert.deepEqual(Array.prototype.slice.call(data.columns.COLINT), [1, 2, 0]);
+  assert.deepEqual(Array.prototype.slice.call(data.columns.COLDOUBLE), [1.5, 0, 3.5]);
+  assert.deepEqual(data.columns.COLTEXT, ["one", "two", null]);
+  
+  assert.deepEqual(Array.prototype.slice.call(data.nulls.COLINT), [0, 0, 1]);
+  assert.deepEqual(Array.prototype.slice.call(data.nulls.COLDOUBLE), [0, 1, 0]);
+  assert.deepEqual(Array.prototype.slice.call(data.nulls.COLTEXT), [0, 0, 1]);
+});
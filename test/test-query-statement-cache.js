@@ -0,0 +1,37 @@
+var common = require("./common")
+  , odbc = require("../")
+  , db = new odbc.Database({ statementCacheSize : 1 })
+  , assert = require("assert")
+  ;
+
+db.openSync(common.connectionString);
+assert.equal(db.connected, true);
+assert.equal(db.conn.statementCacheSize, 1);
+
+db.query("select ? as COLINT", [1], function (err, data) {
+  assert.equal(err, null);
+  assert.deepEqual(data, [{ COLINT : 1 }]);
+  assert.equal(db.conn.statementCacheMisses, 1);
+  
+  db.query("select ? as COLINT", [2], function (err, data) {
+    assert.equal(err, null);
+    assert.deepEqual(data, [{ COLINT : 2 }]);
+    assert.equal(db.conn.statementCacheHits, 1);
+    
+    //pushes the first statement out of the cache
+    db.query("select ? as COLTEXT", ['fish'], function (err, data) {
+      assert.equal(err, null);
+      assert.deepEqual(data, [{ COLTEXT : 'fish' }]);
+      
+      db.query("select ? as COLINT", [3], function (err, data) {
+        assert.equal(err, null);
+        assert.deepEqual(data, [{ COLINT : 3 }]);
+        assert.equal(db.conn.statementCacheHits, 1);
+        assert.equal(db.conn.statementCacheMisses, 3);
+        
+        db.closeSync();
+        console.log("connection closed");
+      });
+    });
+  });
+});
@@ -0,0 +1,35 @@
+var common = require("./common")
+  , odbc = require("../")
+  , db = new odbc.Database({ fetchSize : 2 })
+  , assert = require("assert")
+  , rows = []
+  ;
+
+db.openSync(common.connectionString);
+
+assert.equal(db.connected, true);
+
+db.querySync("create table " + common.tableName + "_STREAMDESTROY (COLINT INTEGER)");
+
+for (var x = 0; x < 10; x++) {
+  db.querySync("insert into " + common.tableName + "_STREAMDESTROY values (" + x + ")");
+}
+
+var stream = db.queryStream("select * from " + common.tableName + "_STREAMDESTROY order by COLINT");
+
+stream.on("data", function (row) {
+  rows.push(row);
+  
+  //give up on the rest; the connection must not stay busy with it
+  if (rows.length === 1) {
+    stream.destroy();
+  }
+});
+
+//queued behind the stream, so it only runs once the stream lets go
+db.query("drop table " + common.tableName + "_STREAMDESTROY", function (err) {
+  assert.equal(err, null);
+  assert.deepEqual(rows[0], { COLINT : 0 });
+  
+  db.closeSync();
+});
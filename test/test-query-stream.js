@@ -0,0 +1,42 @@
+var common = require("./common")
+  , odbc = require("../")
+  , db = new odbc.Database({ fetchSize : 2 })
+  , assert = require("assert")
+  , rows = []
+  ;
+
+db.openSync(common.connectionString);
+
+assert.equal(db.connected, true);
+
+db.querySync("create table " + common.tableName + "_STREAM (COLINT INTEGER, COLTEXT VARCHAR(20))");
+
+for (var x = 0; x < 5; x++) {
+  db.querySync("insert into " + common.tableName + "_STREAM values (" + x + ", 'row " + x + "')");
+}
+
+var stream = db.queryStream("select * from " + common.tableName + "_STREAM order by COLINT");
+
+stream.on("data", function (row) {
+  rows.push(row);
+});
+
+stream.on("error", function (err) {
+  assert.ifError(err);
+});
+
+stream.on("end", function () {
+  //queries issued after the stream are queued until it is done
+  db.query("drop table " + common.tableName + "_STREAM", function (err) {
+    db.closeSync();
+    
+    assert.equal(err, null);
+    assert.deepEqual(rows, [
+        { COLINT : 0, COLTEXT : "row 0" }
+      , { COLINT : 1, COLTEXT : "row 1" }
+      , { COLINT : 2, COLTEXT : "row 2" }
+      , { COLINT : 3, COLTEXT : "row 3" }
+      , { COLINT : 4, COLTEXT : "row 4" }
+    ]);
+  });
+});
@@ -0,0 +1,80 @@
+var common = require("./common")
+  , odbc = require("../")
+  , db = new odbc.Database({ queryTimeout : 30 })
+  , assert = require("assert")
+  //long enough that it is still running when it is canceled
+  , slowSql = "with recursive c(x) as (select 1 union all select x + 1 from c where x < 100000000) "
+    + "select count(*) as COLINT from c"
+  ;
+
+db.openSync(common.connectionString);
+assert.equal(db.conn.queryTimeout, 30);
+
+db.query({ sql : "select ? as COLINT", params : [1], timeout : 10 }, function (err, data) {
+  assert.equal(err, null);
+  assert.deepEqual(data, [{ COLINT : 1 }]);
+  
+  db.prepare("select ? as COLINT", function (err, stmt) {
+    assert.equal(err, null);
+    assert.equal(stmt.queryTimeout, 30);
+    
+    stmt.queryTimeout = 5;
+    assert.equal(stmt.queryTimeout, 5);
+    
+    stmt.execute([2], function (err, result) {
+      assert.equal(err, null);
+      
+      //canceling a result that is not doing anything does not affect the
+      //next fetch
+      assert.equal(result.cancel(), true);
+      
+      result.fetchAll(function (err, data) {
+        assert.equal(err, null);
+        assert.deepEqual(data, [{ COLINT : 2 }]);
+        result.closeSync();
+        
+        testCancelRunning();
+      });
+    });
+  });
+});
+
+//cancel a query while the driver is working on it
+function testCancelRunning() {
+  db.prepare(slowSql, function (err, stmt) {
+    assert.equal(err, null);
+    
+    var running = stmt
+      , started = Date.now()
+      ;
+    
+    setTimeout(function () {
+      running.cancel();
+    }, 200);
+    
+    stmt.execute(function (err, result) {
+      if (err) {
+        return done(err);
+      }
+      
+      //the driver put off the work until the first fetch
+      running = result;
+      
+      result.fetchAll(function (err) {
+        result.closeSync();
+        
+        done(err);
+      });
+    });
+    
+    function done(err) {
+      assert.ok(err);
+      //stopped long before the query could have finished
+      assert.ok(Date.now() - started < 5000);
+      
+      stmt.closeSync();
+      db.closeSync();
+      console.log("connection closed");
+    }
+  });
+}
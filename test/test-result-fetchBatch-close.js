@@ -0,0 +1,42 @@
+var common = require("./common")
+  , odbc = require("../")
+  , db = new odbc.Database()
+  , assert = require("assert")
+  ;
+
+db.openSync(common.connectionString);
+
+assert.equal(db.connected, true);
+
+db.querySync("create table " + common.tableName + "_BATCHCLOSE (COLINT INTEGER, COLTEXT VARCHAR(20))");
+
+for (var x = 0; x < 50; x++) {
+  db.querySync("insert into " + common.tableName + "_BATCHCLOSE values (" + x + ", 'row " + x + "')");
+}
+
+db.conn.query("select * from " + common.tableName + "_BATCHCLOSE order by COLINT", function (err, result) {
+  assert.equal(err, null);
+  
+  result.fetchSize = 5;
+  
+  result.fetchBatch(function (err, rows) {
+    assert.equal(err, null);
+    assert.equal(rows.length, 5);
+    
+    //the next batch is already being fetched; closing must wait for it
+    //instead of freeing the statement out from under it
+    result.closeSync();
+    
+    //asking for it now is answered once the fetch has stopped
+    result.fetchBatch(function (err, rows) {
+      assert.ok(err);
+      assert.equal(rows, null);
+      
+      db.query("drop table " + common.tableName + "_BATCHCLOSE", function (err) {
+        assert.equal(err, null);
+        
+        db.closeSync();
+      });
+    });
+  });
+});
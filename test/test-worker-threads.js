@@ -0,0 +1,43 @@
+var common = require("./common")
+  , odbc = require("../")
+  , assert = require("assert")
+  , openCount = 10
+  , remaining = openCount
+  ;
+
+assert.equal(odbc.getWorkerThreads(), 0);
+assert.throws(function () {
+  odbc.setWorkerThreads(0);
+});
+
+assert.equal(odbc.setWorkerThreads(2), 2);
+assert.equal(odbc.setWorkerThreads(6), 6);
+//the pool does not shrink
+assert.equal(odbc.setWorkerThreads(1), 6);
+assert.equal(odbc.getWorkerThreads(), 6);
+
+//half of the connections have a thread of their own; the rest share the pool
+for (var x = 0; x < openCount; x++) {
+  (function (pinned) {
+    var db = new odbc.Database({ pinnedWorker : pinned });
+    
+    db.open(common.connectionString, function (err) {
+      assert.equal(err, null);
+      assert.equal(db.conn.pinnedWorker, pinned);
+      
+      db.query("select 1 as COLINT", function (err, data) {
+        assert.equal(err, null);
+        assert.deepEqual(data, [{ COLINT : 1 }]);
+        
+        db.conn.pinnedWorker = false;
+        assert.equal(db.conn.pinnedWorker, false);
+        
+        db.close(function () {
+          if (--remaining === 0) {
+            console.log("Done");
+          }
+        });
+      });
+    });
+  })(x % 2 === 0);
+}